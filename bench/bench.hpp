@@ -0,0 +1,52 @@
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstddef>
+
+using std::size_t;
+
+/**
+ * minimal benchmark helpers, every benchmark is a plain executable
+ * printing one line per measurement
+ */
+struct bench_result
+{
+    double seconds;
+    size_t iterations;
+
+    double rate() const
+    { return seconds > 0 ? iterations / seconds : 0; }
+};
+
+// runs fn(i) for i in [0, iterations) and times the whole loop
+template<typename Fn>
+bench_result measure(size_t iterations, Fn && fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; ++i)
+        fn(i);
+    auto stop = std::chrono::steady_clock::now();
+
+    return {std::chrono::duration<double>(stop - start).count(), iterations};
+}
+
+inline void report(std::string const & name, bench_result const & r,
+    std::string const & unit = "ops")
+{
+    std::cout << std::left << std::setw(48) << name
+              << std::right << std::setw(14) << std::fixed 
+              << std::setprecision(0) << r.rate() << " " << unit << "/s"
+              << std::setw(12) << std::setprecision(3) 
+              << r.seconds * 1e3 << " ms" << std::endl;
+}
+
+// keeps the optimizer from discarding a value
+template<typename T>
+inline void do_not_optimize(T const & value)
+{ asm volatile("" : : "r,m"(value) : "memory"); }
+
+#endif
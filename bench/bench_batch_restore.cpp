@@ -0,0 +1,63 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "batch_restore.hpp"
+
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// restores an archive of count coroutines with 1 to N threads
+int main(int ac, char * av[])
+{
+    size_t count = ac > 1 ? std::stoul(av[1]) : 200'000;
+    size_t max_threads = ac > 2 ? std::stoul(av[2]) 
+        : std::max(1u, std::thread::hardware_concurrency());
+
+    std::string archive;
+    {
+        int x = 5;
+        std::vector<saveable<lazy<int>>> chains;
+        snapshot_archive_writer writer;
+        for(size_t i = 0; i < count; ++i)
+        {
+            chains.push_back(make_chain(1 + i % 4, x));
+            writer.add(i, chains.back());
+        }
+
+        std::ostringstream os;
+        writer.write(os);
+        archive = os.str();
+
+        for(auto & chain : chains)
+            destroy_chain(chain.address());
+    }
+
+    std::vector<std::max_align_t> memory(
+        archive.size() / sizeof(std::max_align_t) + 1);
+    std::memcpy(memory.data(), archive.data(), archive.size());
+    snapshot_archive_view view({reinterpret_cast<char*>(memory.data()), 
+        archive.size()});
+
+    std::cout << "archive " << archive.size() << " bytes, " << count 
+              << " coroutines" << std::endl;
+
+    // every coroutine gets its own argument
+    std::vector<int> args(count, 7);
+    auto args_for = [&args](size_t i) { return std::tie(args[i]); };
+
+    for(size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        std::vector<saveable<lazy<int>>> restored;
+        auto r = measure(1, [&](size_t) {
+            restored = restore_all<lazy<int>>(view, threads, args_for);
+        });
+        r.iterations = count;
+        report("restore_all " + std::to_string(threads) + " threads", r,
+            "coroutines");
+
+        for(auto & coroutine : restored)
+            destroy_chain(coroutine.address());
+    }
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef __BENCH_CHAIN_HPP__
+#define __BENCH_CHAIN_HPP__
+
+#include "saveable_coroutine.hpp"
+#include "no_yield.hpp"
+
+#include <coroutine>
+
+inline saveable<lazy<int>> chain_frame(int x)
+{ co_return x + 1; }
+
+// links n unstarted frames into an await chain by hand, which is all save
+// and load_coro look at
+inline saveable<lazy<int>> make_chain(size_t n, int & x)
+{
+    auto root = chain_frame(x);
+    frame_header * header = root.get_header();
+
+    for(size_t i = 1; i < n; ++i)
+    {
+        auto child = chain_frame(x);
+        header->child_address = child.address();
+        header = child.get_header();
+    }
+
+    return root;
+}
+
+inline void destroy_chain(void * address)
+{
+    while(address != nullptr)
+    {
+        void * child = 
+            saveable_promise<void>::header_from(address)->child_address;
+        std::coroutine_handle<>::from_address(address).destroy();
+        address = child;
+    }
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "checkpoint_writer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// time spent in the calling thread per checkpoint
+struct latencies
+{
+    std::vector<double> m_micros;
+
+    template<typename Fn>
+    void time(Fn && fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+        m_micros.push_back(
+            std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+
+    void report(std::string const & name)
+    {
+        std::sort(m_micros.begin(), m_micros.end());
+        auto at = [this](double q) {
+            return m_micros[size_t(q * (m_micros.size() - 1))];
+        };
+        std::cout << std::left << std::setw(48) << name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << " p50 " << std::setw(9) << at(0.5) << " us"
+                  << " p99 " << std::setw(9) << at(0.99) << " us"
+                  << " max " << std::setw(9) << m_micros.back() << " us"
+                  << std::endl;
+    }
+};
+
+void run(char const * path, size_t n, size_t checkpoints)
+{
+    int x = 5;
+    auto chain = make_chain(n, x);
+
+    std::string prefix = "chain " + std::to_string(n) + " ";
+
+    // every checkpoint is durable before the game thread continues
+    std::remove(path);
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    latencies blocking;
+    for(size_t i = 0; i < checkpoints; ++i)
+        blocking.time([&]{
+            chain.save(fd);
+            ::fdatasync(fd);
+        });
+    ::close(fd);
+    blocking.report(prefix + "save + fdatasync");
+
+    // the game thread only stages, the writer thread syncs in batches
+    std::remove(path);
+    latencies staged;
+    std::uint64_t syncs = 0;
+    {
+        checkpoint_writer writer(path);
+        for(size_t i = 0; i < checkpoints; ++i)
+            staged.time([&]{ writer.checkpoint(i % 16, chain); });
+        writer.flush();
+        syncs = writer.syncs();
+    }
+    staged.report(prefix + "checkpoint_writer::checkpoint");
+    std::cout << prefix << checkpoints << " checkpoints in " << syncs 
+              << " syncs\n" << std::endl;
+
+    std::remove(path);
+    destroy_chain(chain.address());
+}
+
+int main(int ac, char * av[])
+{
+    char const * path = ac > 1 ? av[1] : "bench_checkpoint_writer.log";
+    size_t checkpoints = ac > 2 ? std::stoul(av[2]) : 2'000;
+
+    run(path, 1, checkpoints);
+    run(path, 10, checkpoints);
+    run(path, 100, checkpoints);
+
+    return 0;
+}
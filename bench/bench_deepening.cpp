@@ -0,0 +1,111 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac4.hpp"
+#include "alpha_beta.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+using player_type = AlphaBetaInterface<TicTac4>;
+
+// times every move it searches, the opening move is played as told
+struct timed_player : public player_type
+{
+    timed_player(budget const& b, std::optional<TicTac4::Move> opening) :
+        player_type{b}, m_opening{opening}
+    { }
+
+    task<action_type> select(Ranges<action_type> const & actions) override
+    {
+        if(auto opening = std::exchange(m_opening, std::nullopt))
+            co_return *opening;
+
+        auto start = clock_type::now();
+        action_type action = co_await player_type::select(actions);
+        m_micros.push_back(std::chrono::duration<double, std::micro>(
+            clock_type::now() - start).count());
+        m_depths.push_back(depth());
+        co_return action;
+    }
+
+    std::optional<TicTac4::Move> m_opening;
+    std::vector<double> m_micros;
+    std::vector<int> m_depths;
+};
+
+// whole 4x4 games between two players searching within the budget, X
+// opening on every square in turn
+void play(std::string const & name, player_type::budget const& b, 
+    double slo_micros, size_t games)
+{
+    std::vector<double> micros;
+    double depths = 0;
+    size_t complete = 0; // moves that saw every game end
+
+    for(size_t g = 0; g < games; ++g)
+    {
+        GameInterface<TicTac4> game;
+        timed_player x(b, (TicTac4::Move)(g % TicTac4::TotalMoves));
+        timed_player o(b, std::nullopt);
+        game.add_player(x);
+        game.add_player(o);
+        do_not_optimize(turn_based(&game).get());
+
+        for(auto * p : {&x, &o})
+        {
+            micros.insert(micros.end(), p->m_micros.begin(), 
+                p->m_micros.end());
+            for(int d : p->m_depths)
+                if(d == alpha_beta_search<TicTac4>::unlimited)
+                    ++complete;
+                else
+                    depths += d;
+        }
+    }
+
+    std::sort(micros.begin(), micros.end());
+    auto at = [&](double q) {
+        return micros[size_t(q * (micros.size() - 1))];
+    };
+    size_t limited = micros.size() - complete;
+    std::cout << std::left << std::setw(48) << name << std::right
+              << std::fixed << std::setprecision(1)
+              << " p50 " << std::setw(9) << at(0.5) << " us"
+              << " p99 " << std::setw(9) << at(0.99) << " us"
+              << " max " << std::setw(9) << micros.back() << " us"
+              << std::endl;
+    std::cout << std::left << std::setw(48) << "" << std::right
+              << std::setw(6) << micros.size() << " moves, "
+              << complete << " to the end, the rest " 
+              << std::setprecision(1) << (limited ? depths / limited : 0) 
+              << " plies deep, p99 "
+              << (at(0.99) <= slo_micros ? "within" : "over") 
+              << " target" << std::endl;
+}
+
+int main(int ac, char * av[])
+{
+    using namespace std::chrono_literals;
+    size_t games = ac > 1 ? std::stoul(av[1]) : 16;
+
+    // a p99 latency target, searched within 95% of it so the last
+    // nodes before the deadline and the move itself fit
+    for(auto t : {1ms, 5ms, 20ms})
+    {
+        double slo_micros = 
+            std::chrono::duration<double, std::micro>(t).count();
+        play("4x4 games, p99 target " + std::to_string(t.count()) + " ms", 
+            {.m_time = std::chrono::microseconds(t) * 95 / 100}, 
+            slo_micros, games);
+    }
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "bench.hpp"
+#include "frame_allocator.hpp"
+#include "saveable_coroutine.hpp"
+#include "no_yield.hpp"
+
+#include <sstream>
+#include <vector>
+
+// lazy<long> frames go straight to the heap, lazy<int> uses the default
+// pooled allocator
+template<>
+struct saveable_traits<lazy<long>> : saveable_traits<void>
+{
+    using allocator_type = heap_frame_allocator;
+};
+
+saveable<lazy<int>> pooled_frame(int x)
+{ co_return x + 1; }
+
+saveable<lazy<long>> heap_frame(int x)
+{ co_return x + 1; }
+
+template<typename Allocator>
+bench_result allocate_frames(size_t iterations)
+{
+    // a handful of live frames of mixed size, recycled in fifo order
+    static constexpr size_t sizes[] = { 96, 160, 256, 512 };
+    std::vector<void*> live(64, nullptr);
+
+    auto r = measure(iterations, [&](size_t i) {
+        size_t slot = i % live.size();
+        size_t size = sizes[i % 4];
+        if(live[slot] != nullptr)
+            Allocator::deallocate(live[slot], sizes[(i - live.size()) % 4]);
+        live[slot] = Allocator::allocate(size);
+    });
+
+    for(size_t slot = 0; slot < live.size(); ++slot)
+        if(live[slot] != nullptr)
+            Allocator::deallocate(live[slot], 
+                sizes[(iterations - live.size() + slot) % 4]);
+
+    return r;
+}
+
+template<typename Coroutine>
+bench_result create_frames(size_t iterations, Coroutine && coroutine)
+{
+    return measure(iterations, [&](size_t i) {
+        auto coro = coroutine((int)i);
+        do_not_optimize(coro.address());
+        coro.destroy();
+    });
+}
+
+template<typename HandleType, typename Coroutine>
+bench_result restore_frames(size_t iterations, Coroutine && coroutine)
+{
+    int x = 5;
+    auto coro = coroutine(x);
+
+    std::stringstream ss;
+    coro.save(ss);
+    coro.destroy();
+    std::string const saved = ss.str();
+
+    std::istringstream is(saved);
+    return measure(iterations, [&](size_t) {
+        is.clear();
+        is.seekg(0);
+        auto loaded = load_coro<HandleType>(is, x);
+        do_not_optimize(loaded.address());
+        loaded.destroy();
+    });
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 2'000'000;
+
+    report("allocate/deallocate heap", 
+        allocate_frames<heap_frame_allocator>(iterations), "allocs");
+    report("allocate/deallocate pooled", 
+        allocate_frames<pooled_frame_allocator<>>(iterations), "allocs");
+
+    report("create/destroy saveable frame heap", 
+        create_frames(iterations, heap_frame), "frames");
+    report("create/destroy saveable frame pooled", 
+        create_frames(iterations, pooled_frame), "frames");
+
+    report("load_coro/destroy heap", 
+        restore_frames<lazy<long>>(iterations, heap_frame), "frames");
+    report("load_coro/destroy pooled", 
+        restore_frames<lazy<int>>(iterations, pooled_frame), "frames");
+
+    return 0;
+}
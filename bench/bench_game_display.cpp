@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+
+#include <sstream>
+#include <memory>
+#include <vector>
+
+// renders every state it is shown, about what a text client costs
+struct rendering_player : public PlayerInterface<TicTac>
+{
+    task<void> display(TicTac const & state) override
+    {
+        std::ostringstream os;
+        os << state;
+        m_bytes += os.str().size();
+        co_return;
+    }
+
+    task<action_type> select(Ranges<action_type> const & actions) override
+    { co_return actions.begin()->begin(); }
+
+    size_t m_bytes = 0;
+};
+
+template<typename Game>
+bench_result run(Game & game, size_t players, size_t iterations)
+{
+    std::vector<std::unique_ptr<rendering_player>> clients;
+    for(size_t i = 0; i < players; ++i)
+    {
+        clients.push_back(std::make_unique<rendering_player>());
+        game.add_player(*clients.back());
+    }
+
+    TicTac state;
+    state(TicTac::Center);
+
+    // a threaded display finishes on a pool thread
+    return measure(iterations, [&](size_t) {
+        sync_wait(game.display(state));
+    });
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 20'000;
+    size_t threads = ac > 2 ? std::stoul(av[2]) 
+                            : std::thread::hardware_concurrency();
+
+    std::cout << threads << " worker threads\n" << std::endl;
+
+    for(size_t players : {2, 8, 64})
+    {
+        std::string prefix = std::to_string(players) + " players ";
+        size_t n = iterations * 8 / players;
+
+        GameInterface<TicTac> sequential;
+        auto s = run(sequential, players, n);
+        report(prefix + "GameInterface::display", s, "displays");
+
+        ThreadedGame<TicTac> threaded(threads);
+        auto t = run(threaded, players, n);
+        report(prefix + "ThreadedGame::display", t, "displays");
+
+        std::cout << prefix << std::setprecision(0) 
+                  << players * t.rate() << " player updates/s\n" 
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "game_server.hpp"
+#include "tictac.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using clock_type = std::chrono::steady_clock;
+
+// players of every game waiting for an action, nullptr when a game is over
+struct client_queue
+{
+    using entry = std::pair<remote_player<TicTac>*, TicTac::Move>;
+
+    void push(entry e)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_entries.push_back(e);
+        }
+        m_cond.notify_one();
+    }
+
+    entry pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_cond.wait(lock, [this]{ return !m_entries.empty(); });
+        entry e = m_entries.front();
+        m_entries.pop_front();
+        return e;
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<entry> m_entries;
+};
+
+struct hosted_game;
+
+// picks a pseudo random open square so games differ in length
+struct load_player : public remote_player<TicTac>
+{
+    load_player(scheduler sched, client_queue & queue, hosted_game & game,
+        unsigned seed) :
+        remote_player<TicTac>{sched}, m_queue{queue}, m_game{game},
+        m_seed{seed}
+    { }
+
+    task<void> display(TicTac const &) override
+    { co_return; }
+
+    void turn(Ranges<action_type> const & actions) override;
+
+    client_queue & m_queue;
+    hosted_game & m_game;
+    unsigned m_seed;
+};
+
+struct hosted_game
+{
+    hosted_game(scheduler sched, client_queue & queue, unsigned seed) :
+        x{sched, queue, *this, seed}, o{sched, queue, *this, seed * 7 + 1}
+    {
+        game.add_player(x);
+        game.add_player(o);
+        m_micros.reserve(9);
+    }
+
+    // from the client handing in a move to the server asking for the next
+    // one, or to the end of the game
+    void moved()
+    {
+        if(m_submitted == clock_type::time_point{})
+            return;
+
+        m_micros.push_back(std::chrono::duration<double, std::micro>(
+            clock_type::now() - m_submitted).count());
+    }
+
+    GameInterface<TicTac> game;
+    load_player x, o;
+    clock_type::time_point m_submitted{};
+    std::vector<double> m_micros;
+};
+
+void load_player::turn(Ranges<action_type> const & actions)
+{
+    m_game.moved();
+
+    std::vector<action_type> open;
+    for(auto const & r : actions)
+        for(auto m = r.begin(); m != r.end(); ++m)
+            open.push_back(m);
+
+    m_seed = m_seed * 1103515245 + 12345;
+    m_queue.push({this, open[(m_seed >> 16) % open.size()]});
+}
+
+// keeps `concurrent` games running until `total` have been played
+struct load_generator
+{
+    load_generator(game_server & server, size_t total, size_t concurrent) :
+        m_server{server}, m_concurrent{concurrent}, m_next{0}
+    {
+        for(size_t i = 0; i < total; ++i)
+            m_games.push_back(std::make_unique<hosted_game>(
+                server.get_scheduler(), m_queue, unsigned(i + 1)));
+    }
+
+    void start(size_t i)
+    {
+        hosted_game * g = m_games[i].get();
+        m_server.host(g->game, [this, g](TicTac const &) {
+            g->moved();
+            size_t next = m_next.fetch_add(1, std::memory_order_relaxed);
+            if(next < m_games.size())
+                start(next);
+            m_queue.push({nullptr, TicTac::TotalMoves});
+        });
+    }
+
+    // plays every game, answering the server from the calling thread
+    size_t run()
+    {
+        m_next = std::min(m_concurrent, m_games.size());
+        for(size_t i = 0; i < m_next; ++i)
+            start(i);
+
+        size_t over = 0, moves = 0;
+        while(over < m_games.size())
+        {
+            auto [player, move] = m_queue.pop();
+            if(player == nullptr)
+            {
+                ++over;
+                continue;
+            }
+
+            static_cast<load_player*>(player)->m_game.m_submitted =
+                clock_type::now();
+            player->submit(move);
+            ++moves;
+        }
+
+        m_server.wait();
+        return moves;
+    }
+
+    void report(std::string const & name)
+    {
+        std::vector<double> micros;
+        for(auto const & g : m_games)
+            micros.insert(micros.end(), g->m_micros.begin(),
+                g->m_micros.end());
+
+        std::sort(micros.begin(), micros.end());
+        auto at = [&](double q) {
+            return micros[size_t(q * (micros.size() - 1))];
+        };
+        std::cout << std::left << std::setw(48) << name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << " p50 " << std::setw(9) << at(0.5) << " us"
+                  << " p99 " << std::setw(9) << at(0.99) << " us"
+                  << " max " << std::setw(9) << micros.back() << " us"
+                  << std::endl;
+    }
+
+    game_server & m_server;
+    client_queue m_queue;
+    std::vector<std::unique_ptr<hosted_game>> m_games;
+    size_t m_concurrent;
+    std::atomic<size_t> m_next;
+};
+
+int main(int ac, char * av[])
+{
+    size_t total = ac > 1 ? std::stoul(av[1]) : 20'000;
+    size_t threads = ac > 2 ? std::stoul(av[2])
+                            : std::thread::hardware_concurrency();
+
+    std::cout << threads << " worker threads, " << total << " games\n"
+              << std::endl;
+
+    for(size_t concurrent : {10, 1'000, 10'000})
+    {
+        std::string prefix = std::to_string(concurrent) + " concurrent ";
+
+        game_server server(threads);
+        load_generator load(server, total, concurrent);
+
+        size_t moves = 0;
+        auto r = measure(1, [&](size_t) { moves = load.run(); });
+
+        report(prefix + "games", {r.seconds, total}, "games");
+        report(prefix + "moves", {r.seconds, moves}, "moves");
+        load.report(prefix + "move latency");
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
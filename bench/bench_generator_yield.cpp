@@ -0,0 +1,61 @@
+#include "bench.hpp"
+#include "generator.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+
+#include <array>
+#include <string>
+
+// a state of Size bytes, the producer changes one byte per element
+template<size_t Size>
+struct blob
+{
+    std::array<unsigned char, Size> m_bytes{};
+};
+
+template<typename State, typename Yield>
+generator<Yield> states(size_t n)
+{
+    State state{};
+    auto * bytes = reinterpret_cast<unsigned char*>(&state);
+    for(size_t i = 0; i < n; ++i)
+    {
+        bytes[i % sizeof(State)] ^= 1;
+        co_yield state;
+    }
+}
+
+template<typename State, typename Yield>
+bench_result iterate(size_t n)
+{
+    unsigned sum = 0;
+    auto r = measure(1, [&](size_t) {
+        for(auto && state : states<State, Yield>(n))
+            sum += reinterpret_cast<unsigned char const*>(&state)[0];
+    });
+    do_not_optimize(sum);
+    return {r.seconds, n};
+}
+
+template<typename State>
+void run(std::string const & name, size_t n)
+{
+    report(name + " by value", iterate<State, State>(n), "states");
+    report(name + " by reference", iterate<State, State const&>(n),
+        "states");
+}
+
+int main(int ac, char * av[])
+{
+    size_t n = ac > 1 ? std::stoul(av[1]) : 5'000'000;
+
+    run<TicTac>("TicTac (" + std::to_string(sizeof(TicTac)) + " B)", n);
+    run<blob<256>>("256 B state", n);
+    run<blob<1024>>("1 KiB state", n);
+    run<blob<4096>>("4 KiB state", n / 4);
+
+    return 0;
+}
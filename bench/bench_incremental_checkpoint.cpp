@@ -0,0 +1,74 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "incremental_checkpoint.hpp"
+
+#include <sstream>
+
+// a leaf frame that changes a local every time it is resumed
+saveable<lazy<int>> ticker(int x)
+{
+    std::suspend_always tick;
+    for(;;)
+    {
+        ++x;
+        co_await tick;
+    }
+}
+
+// checkpoint volume of a chain where only the leaf frame changes between
+// checkpoints, full snapshots versus incremental deltas
+int main(int ac, char * av[])
+{
+    size_t checkpoints = ac > 1 ? std::stoul(av[1]) : 100'000;
+
+    for(size_t n : {1, 10, 100})
+    {
+        int x = 5;
+        auto chain = make_chain(n, x);
+        auto leaf = ticker(x);
+
+        frame_header * header = chain.get_header();
+        while(header->child_address != nullptr)
+            header = saveable_promise<void>::header_from(header->child_address);
+        header->child_address = leaf.address();
+
+        std::string prefix = "chain " + std::to_string(n + 1) + " ";
+
+        std::ostringstream full;
+        auto f = measure(checkpoints, [&](size_t) {
+            leaf.handle().resume();
+            chain.save(full);
+        });
+        report(prefix + "full checkpoint", f, "checkpoints");
+
+        incremental_checkpoint<> tracker;
+        std::ostringstream base, deltas;
+        tracker.save_base(chain, base);
+
+        auto d = measure(checkpoints, [&](size_t) {
+            leaf.handle().resume();
+            tracker.save_delta(chain, deltas);
+        });
+        report(prefix + "incremental checkpoint", d, "checkpoints");
+
+        // every delta replayed on top of the base gives the same chain
+        std::istringstream bis(base.str()), dis(deltas.str());
+        auto restored = load_coro_incremental<lazy<int>>(bis, dis, x);
+        if(restored.snapshot() != chain.snapshot())
+            throw std::logic_error("replayed checkpoints differ");
+        destroy_chain(restored.address());
+
+        size_t full_bytes = full.str().size(), 
+               delta_bytes = deltas.str().size();
+        std::cout << prefix << "bytes per checkpoint: full " 
+                  << full_bytes / checkpoints << ", incremental " 
+                  << delta_bytes / checkpoints << " (" 
+                  << std::setprecision(1) 
+                  << (double)full_bytes / delta_bytes << "x less)\n" 
+                  << std::endl;
+
+        destroy_chain(chain.address());
+    }
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "minimax.hpp"
+#include "alpha_beta.hpp"
+
+#include <initializer_list>
+#include <string>
+
+// a player that is never asked to move, MinimaxInterface needs a game
+// with the right number of players
+struct idle_player : public PlayerInterface<TicTac>
+{
+    task<void> display(TicTac const &) override
+    { co_return; }
+
+    task<action_type> select(Ranges<action_type> const &) override
+    { throw game_error("idle player asked to move"); }
+};
+
+// alpha-beta searching without a transposition table
+struct no_table_player : public AlphaBetaInterface<TicTac>
+{
+    no_table_player() : AlphaBetaInterface<TicTac>(0) { }
+};
+
+// a fresh player per move so nothing is remembered between them
+template<typename Player>
+void time_to_move(std::string const & name, TicTac const & state, 
+    size_t iterations)
+{
+    size_t nodes = 0;
+    double hit_rate = -1;
+    auto r = measure(iterations, [&](size_t) {
+        GameInterface<TicTac> game;
+        Player player;
+        idle_player other;
+        game.add_player(player);
+        game.add_player(other);
+
+        player.display(state).get();
+        do_not_optimize(player.select(state.actions()).get());
+        nodes = player.nodes();
+        if constexpr(requires { player.search().table(); })
+            if(player.search().table())
+                hit_rate = player.search().stats().hit_rate();
+    });
+
+    report(name, r, "moves");
+    std::cout << std::left << std::setw(48) << "" << std::right 
+              << std::setw(14) << nodes << " nodes, " << std::fixed 
+              << std::setprecision(1) << r.seconds * 1e6 / iterations 
+              << " us/move";
+    if(hit_rate >= 0)
+        std::cout << ", " << std::setprecision(1) << hit_rate * 100 
+                  << "% table hits";
+    std::cout << std::endl;
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 5;
+
+    std::initializer_list<TicTac::Move> openings[] = {
+        {},
+        {TicTac::Center},
+        {TicTac::Center, TicTac::TopLeft},
+        {TicTac::TopLeft, TicTac::Center, TicTac::BottomRight},
+    };
+
+    for(auto const & moves : openings)
+    {
+        TicTac state;
+        for(auto m : moves)
+            state(m);
+
+        std::string prefix = std::to_string(moves.size()) + " moves played ";
+        time_to_move<MinimaxInterface<TicTac>>(prefix + "minimax", state,
+            iterations);
+        time_to_move<no_table_player>(prefix + "alpha-beta no table", 
+            state, iterations * 50);
+        time_to_move<AlphaBetaInterface<TicTac>>(prefix + "alpha-beta", 
+            state, iterations * 50);
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
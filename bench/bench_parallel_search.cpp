@@ -0,0 +1,86 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac4.hpp"
+#include "alpha_beta.hpp"
+#include "parallel_search.hpp"
+
+#include <initializer_list>
+#include <string>
+#include <thread>
+
+using search_type = parallel_alpha_beta_search<TicTac4>;
+
+// a fresh search per move so every one starts with an empty table
+search_type::result time_to_move(std::string const & name, 
+    TicTac4 const & state, size_t threads, size_t iterations, 
+    double & seconds)
+{
+    work_stealing_pool pool(threads);
+    scheduler sched(pool);
+
+    search_type::result result{};
+    double hit_rate = 0;
+    auto r = measure(iterations, [&](size_t) {
+        search_type search(sched, threads, 16 << 20);
+        result = sync_wait(search.search(state));
+        hit_rate = search.stats().hit_rate();
+    });
+    seconds = r.seconds / iterations;
+
+    report(name, r, "moves");
+    std::cout << std::left << std::setw(48) << "" << std::right
+              << std::setw(14) << result.m_nodes << " nodes, " << std::fixed
+              << std::setprecision(1) << hit_rate * 100 << "% table hits"
+              << std::endl;
+    return result;
+}
+
+// 4x4 tic-tac-toe searched to the end on 1 to N threads
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 3;
+    size_t max_threads = ac > 2 ? std::stoul(av[2]) 
+        : std::max(4u, std::thread::hardware_concurrency());
+
+    std::cout << std::thread::hardware_concurrency() << " cores" 
+              << std::endl;
+
+    std::initializer_list<int> openings[] = { {}, {5}, {5, 10} };
+    for(auto const & moves : openings)
+    {
+        TicTac4 state;
+        for(int m : moves)
+            state((TicTac4::Move)m);
+
+        std::string prefix = "4x4 " + std::to_string(moves.size()) + 
+            " moves played ";
+        double base = 0;
+        search_type::result expected{};
+        for(size_t threads = 1; threads <= max_threads; ++threads)
+        {
+            double seconds;
+            auto r = time_to_move(prefix + std::to_string(threads) + 
+                " threads", state, threads, iterations, seconds);
+
+            if(threads == 1)
+            {
+                base = seconds;
+                expected = r;
+            }
+            else if(r.m_action != expected.m_action || 
+                    r.m_score != expected.m_score)
+                std::cout << "result differs from 1 thread" << std::endl;
+
+            std::cout << std::left << std::setw(48) << "" << std::right
+                      << std::setw(14) << std::setprecision(2) 
+                      << base / seconds << "x speedup" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
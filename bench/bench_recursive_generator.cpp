@@ -0,0 +1,105 @@
+#include "bench.hpp"
+#include "generator.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+
+#include <string>
+
+// depth levels of nesting around a leaf yielding n values
+generator<int> leaf(int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// every level passes every value up itself
+generator<int> reyield(int depth, int n)
+{
+    if(depth == 0)
+    {
+        for(int v : leaf(n))
+            co_yield v;
+        co_return;
+    }
+
+    for(int v : reyield(depth - 1, n))
+        co_yield v;
+}
+
+generator<int> nested(int depth, int n)
+{
+    if(depth == 0)
+        co_yield elements_of(leaf(n));
+    else
+        co_yield elements_of(nested(depth - 1, n));
+}
+
+// the game tree recursively, every level re-yielding its subtree
+generator<TicTac const&> reyield_tree(TicTac state)
+{
+    co_yield state;
+
+    auto actions = state.actions();
+    for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+    {
+        TicTac next = state;
+        next(*a);
+        for(auto const & s : reyield_tree(next))
+            co_yield s;
+    }
+}
+
+generator<TicTac const&> nested_tree(TicTac state)
+{
+    co_yield state;
+
+    auto actions = state.actions();
+    for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+    {
+        TicTac next = state;
+        next(*a);
+        co_yield elements_of(nested_tree(next));
+    }
+}
+
+template<typename Gen>
+bench_result count(Gen && gen)
+{
+    size_t n = 0;
+    auto r = measure(1, [&](size_t) {
+        for(auto && v : gen)
+        {
+            do_not_optimize(v);
+            ++n;
+        }
+    });
+    return {r.seconds, n};
+}
+
+int main(int ac, char * av[])
+{
+    int n = ac > 1 ? std::stoi(av[1]) : 1'000'000;
+
+    for(int depth : {1, 8, 64, 512})
+    {
+        std::string prefix = "depth " + std::to_string(depth) + " ";
+        report(prefix + "re-yield", count(reyield(depth, n / depth)),
+            "elements");
+        report(prefix + "elements_of", count(nested(depth, n / depth)),
+            "elements");
+    }
+
+    std::cout << std::endl;
+
+    report("tic-tac-toe tree re-yield", count(reyield_tree(TicTac{})),
+        "states");
+    report("tic-tac-toe tree elements_of", count(nested_tree(TicTac{})),
+        "states");
+    report("tic-tac-toe tree explicit stack", count(game_tree(TicTac{})),
+        "states");
+
+    return 0;
+}
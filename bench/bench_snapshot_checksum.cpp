@@ -0,0 +1,68 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "checksum.hpp"
+
+#include <vector>
+
+void run_crc(size_t size, size_t iterations)
+{
+    std::vector<char> data(size, 'x');
+    std::uint32_t crc = 0;
+
+    auto r = measure(iterations, [&](size_t) {
+        crc = crc32c::update(crc, data.data(), data.size());
+    });
+    do_not_optimize(crc);
+
+    report("crc32c " + std::to_string(size) + " bytes", r, "blocks");
+    std::cout << "crc32c " << std::setprecision(1) 
+              << size * r.rate() / (1 << 20) << " MiB/s\n" << std::endl;
+}
+
+void run(size_t n, size_t iterations)
+{
+    int x = 5;
+    auto chain = make_chain(n, x);
+    std::vector<char> const snapshot = chain.snapshot();
+
+    std::string prefix = "chain " + std::to_string(n) + " ";
+
+    auto validated = measure(iterations, [&](size_t) {
+        do_not_optimize(validate_snapshot(snapshot));
+    });
+    report(prefix + "validate_snapshot", validated, "snapshots");
+
+    auto loaded = measure(iterations, [&](size_t) {
+        auto coroutine = load_coro<lazy<int>>(
+            std::span<char const>{snapshot}, x);
+        destroy_chain(coroutine.address());
+    });
+    report(prefix + "load_coro (validating)", loaded, "loads");
+
+    // validation is part of every load, this is its share
+    std::cout << prefix << "validation " << std::setprecision(1) 
+              << 100 * validated.seconds / loaded.seconds 
+              << "% of a load\n" << std::endl;
+
+    destroy_chain(chain.address());
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 200'000;
+
+#if defined(__SSE4_2__)
+    std::cout << "crc32c: sse4.2\n" << std::endl;
+#else
+    std::cout << "crc32c: slicing-by-8\n" << std::endl;
+#endif
+
+    run_crc(4096, iterations);
+    run_crc(64 << 10, iterations / 16);
+
+    run(1, iterations);
+    run(10, iterations / 10);
+    run(100, iterations / 100);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "snapshot_codec.hpp"
+
+#include <string>
+#include <vector>
+
+// snapshot size and encode/decode throughput, raw versus lz_codec frames
+void run(size_t n, size_t iterations)
+{
+    int x = 5;
+    auto chain = make_chain(n, x);
+    std::string prefix = "chain " + std::to_string(n) + " ";
+
+    for(auto encoding : {snapshot_encoding::raw, snapshot_encoding::lz})
+    {
+        std::string name = prefix + 
+            (encoding == snapshot_encoding::raw ? "raw " : "lz ");
+
+        std::vector<char> buffer;
+        auto encoded = measure(iterations, [&](size_t) {
+            buffer.clear();
+            chain.save(buffer, encoding);
+        });
+        report(name + "encode", encoded, "snapshots");
+
+        auto decoded = measure(iterations, [&](size_t) {
+            auto loaded = load_coro<lazy<int>>(
+                std::span<char const>{buffer}, x);
+            destroy_chain(loaded.address());
+        });
+        report(name + "decode", decoded, "snapshots");
+
+        double mib = buffer.size() / double(1 << 20);
+        std::cout << name << "snapshot " << buffer.size() << " bytes, "
+                  << std::setprecision(1) << "encode " 
+                  << mib * encoded.rate() << " MiB/s, decode " 
+                  << mib * decoded.rate() << " MiB/s" << std::endl;
+    }
+    std::cout << std::endl;
+
+    destroy_chain(chain.address());
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 100'000;
+
+    run(1, iterations);
+    run(10, iterations / 10);
+    run(100, iterations / 100);
+
+    return 0;
+}
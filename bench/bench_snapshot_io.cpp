@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+
+#include <sstream>
+#include <vector>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+void run(size_t n, size_t iterations)
+{
+    int x = 5;
+    auto chain = make_chain(n, x);
+    size_t bytes = chain.snapshot_size();
+
+    std::string prefix = "chain " + std::to_string(n) + " ";
+
+    std::ostringstream os;
+    auto streamed = measure(iterations, [&](size_t) {
+        os.seekp(0);
+        chain.save(os);
+    });
+    report(prefix + "save streamed", streamed, "saves");
+
+    auto buffered = measure(iterations, [&](size_t) {
+        os.seekp(0);
+        chain.save_buffered(os);
+    });
+    report(prefix + "save buffered", buffered, "saves");
+
+    int fd = ::open("/dev/null", O_WRONLY);
+    auto gathered = measure(iterations, [&](size_t) {
+        chain.save(fd);
+    });
+    ::close(fd);
+    report(prefix + "save writev /dev/null", gathered, "saves");
+
+    std::string const saved = os.str().substr(0, bytes);
+    std::istringstream is(saved);
+    auto loaded_streamed = measure(iterations, [&](size_t) {
+        is.clear();
+        is.seekg(0);
+        auto loaded = load_coro<lazy<int>>(is, x);
+        destroy_chain(loaded.address());
+    });
+    report(prefix + "load_coro streamed", loaded_streamed, "loads");
+
+    auto loaded_buffered = measure(iterations, [&](size_t) {
+        is.clear();
+        is.seekg(0);
+        auto loaded = load_coro<lazy<int>>(read_snapshot(is), x);
+        destroy_chain(loaded.address());
+    });
+    report(prefix + "load_coro buffered", loaded_buffered, "loads");
+
+    std::cout << prefix << "snapshot " << bytes << " bytes, buffered save " 
+              << std::setprecision(1) 
+              << bytes * buffered.rate() / (1 << 20) << " MiB/s, "
+              << "buffered load " 
+              << bytes * loaded_buffered.rate() / (1 << 20) << " MiB/s\n" 
+              << std::endl;
+
+    destroy_chain(chain.address());
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 200'000;
+
+    run(1, iterations);
+    run(10, iterations / 10);
+    run(100, iterations / 100);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "bench.hpp"
+#include "bench_chain.hpp"
+#include "snapshot_mapping.hpp"
+
+#include <fstream>
+#include <string>
+#include <optional>
+#include <vector>
+#include <cstdio>
+
+// restart time of count suspended coroutines stored back to back in one
+// snapshot file, streamed through load_coro versus restored in place from
+// a copy-on-write mapping
+int main(int ac, char * av[])
+{
+    size_t count = ac > 1 ? std::stoul(av[1]) : 50'000;
+    std::string path = ac > 2 ? av[2] : "bench_snapshot_restore.coro";
+
+    int x = 5;
+    std::vector<size_t> offsets;
+    offsets.reserve(count);
+
+    {
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        size_t offset = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            // chains of 1 to 4 frames
+            auto chain = make_chain(1 + i % 4, x);
+            offsets.push_back(offset);
+            offset += chain.snapshot_size();
+            chain.save_buffered(ofs);
+            destroy_chain(chain.address());
+        }
+        std::cout << "snapshot file " << offset << " bytes, " 
+                  << count << " coroutines" << std::endl;
+    }
+
+    std::vector<void*> restored(count, nullptr);
+    auto destroy_all = [&restored]() {
+        for(void *& address : restored)
+        {
+            destroy_chain(address);
+            address = nullptr;
+        }
+    };
+
+    {
+        std::ifstream ifs;
+        auto r = measure(1, [&](size_t) {
+            ifs.open(path, std::ios::binary);
+            for(size_t i = 0; i < count; ++i)
+                restored[i] = load_coro<lazy<int>>(ifs, x).address();
+        });
+        r.iterations = count;
+        report("restore streamed", r, "coroutines");
+        destroy_all();
+    }
+
+    for(bool populate : {false, true})
+    {
+        std::optional<mapped_snapshot> mapping;
+        auto r = measure(1, [&](size_t) {
+            mapping.emplace(path, populate);
+            for(size_t i = 0; i < count; ++i)
+                restored[i] = 
+                    load_coro<lazy<int>>(*mapping, offsets[i], x).address();
+        });
+        r.iterations = count;
+        report(populate ? "restore mapped in place (populate)" 
+                        : "restore mapped in place", r, "coroutines");
+        destroy_all();
+    }
+
+    std::remove(path.c_str());
+    return 0;
+}
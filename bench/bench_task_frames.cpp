@@ -0,0 +1,69 @@
+#include "bench.hpp"
+#include "task.hpp"
+#include "generator.hpp"
+
+#include <memory>
+
+// the default pooled frames against the global heap, chosen through the
+// allocator argument
+task<int> pooled_leaf(int x)
+{ co_return x + 1; }
+
+task<int> heap_leaf(std::allocator_arg_t, std::allocator<char> const &, int x)
+{ co_return x + 1; }
+
+// a parent awaiting a child, two frames per call
+task<int> pooled_parent(int x)
+{ co_return co_await pooled_leaf(x) * 2; }
+
+task<int> heap_parent(std::allocator_arg_t, std::allocator<char> const & a,
+    int x)
+{ co_return co_await heap_leaf(std::allocator_arg, a, x) * 2; }
+
+generator<int> pooled_count(int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+generator<int> heap_count(std::allocator_arg_t, std::allocator<char>, int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+int main(int ac, char * av[])
+{
+    size_t iterations = ac > 1 ? std::stoul(av[1]) : 5'000'000;
+    std::allocator<char> heap;
+
+    report("task pooled", measure(iterations, [](size_t i) {
+        do_not_optimize(pooled_leaf((int)i).get());
+    }), "tasks");
+    report("task heap", measure(iterations, [&](size_t i) {
+        do_not_optimize(heap_leaf(std::allocator_arg, heap, (int)i).get());
+    }), "tasks");
+
+    report("task + child pooled", measure(iterations, [](size_t i) {
+        do_not_optimize(pooled_parent((int)i).get());
+    }), "tasks");
+    report("task + child heap", measure(iterations, [&](size_t i) {
+        do_not_optimize(
+            heap_parent(std::allocator_arg, heap, (int)i).get());
+    }), "tasks");
+
+    report("generator of 2 pooled", measure(iterations, [](size_t) {
+        int sum = 0;
+        for(int v : pooled_count(2))
+            sum += v;
+        do_not_optimize(sum);
+    }), "generators");
+    report("generator of 2 heap", measure(iterations, [&](size_t) {
+        int sum = 0;
+        for(int v : heap_count(std::allocator_arg, heap, 2))
+            sum += v;
+        do_not_optimize(sum);
+    }), "generators");
+
+    return 0;
+}
@@ -0,0 +1,573 @@
+#ifndef __ALPHA_BETA_HPP__
+#define __ALPHA_BETA_HPP__
+
+#include "game.hpp"
+#include "transposition_table.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Alpha-beta search
+ *
+ * Negamax with alpha-beta pruning and principal variation search: the
+ * first move of every node is searched with the full window, the others
+ * with a null window and only searched again when they turn out better.
+ * Like MinimaxInterface it walks an explicit stack, one frame per ply,
+ * instead of recursing.  Frames are kept between searches so their move
+ * lists stop allocating once the stack has been as deep once.
+ *
+ * Moves are tried best move from the transposition table first, then
+ * killer moves, the last two moves that caused a cutoff at the same ply,
+ * and the rest by their history score.
+ *
+ * Every node looks itself up in a transposition_table keyed by
+ * game_traits::hash, a state reached again by another order of moves is
+ * not searched twice.  A table of 0 bytes turns this off.  Searches on
+ * other threads may share the table, see parallel_alpha_beta_search.
+ *
+ * Scores are from the view of the player to move.  A finished game is
+ * worth win_score less the plies it took when game_traits::score says it
+ * was won, so a quicker win is preferred and a loss is put off.
+ *
+ * search looks all the way to the end of the game.  search_within deepens
+ * one ply at a time instead, guessing at the states where it stops with
+ * game_traits::evaluate, and keeps the move of the deepest search that
+ * finished within its budget of time and nodes.
+ *
+ * HACK: assumes two players taking turns, like MinimaxInterface
+ */
+template<typename State>
+class alpha_beta_search
+{
+public:
+    using action_type = game_traits<State>::action_type;
+
+    using table_type = transposition_table<action_type>;
+
+    static constexpr int win_score = 1'000'000;
+    static constexpr int infinity = win_score + 1;
+    static constexpr size_t default_table_bytes = 1 << 20;
+
+    // plies to search, all the way to the end of the game
+    static constexpr int unlimited = table_type::max_depth;
+
+    explicit alpha_beta_search(size_t table_bytes = default_table_bytes) :
+        m_table{table_bytes > 0 ? std::make_shared<table_type>(table_bytes)
+                                : nullptr},
+        m_ages_table{true}
+    { }
+
+    // shares table with other searches, whoever made it calls new_search
+    explicit alpha_beta_search(std::shared_ptr<table_type> table) :
+        m_table{std::move(table)}, m_ages_table{false}
+    { }
+
+    struct result
+    {
+        action_type m_action;
+        int m_score;
+        size_t m_nodes;
+        int m_depth = unlimited; // unlimited when it saw every game end
+    };
+
+    // what search_within may spend, it stops at whichever runs out first.
+    // time runs over by a few nodes, leave that much under a latency target
+    struct budget
+    {
+        std::chrono::steady_clock::duration m_time =
+            std::chrono::steady_clock::duration::max();
+        size_t m_nodes = std::numeric_limits<size_t>::max();
+        int m_depth = unlimited;
+    };
+
+    // searches to the end of the game, from root limited to actions.  a
+    // score outside the window (alpha, beta) is only a bound on the real
+    // one, and its action is not necessarily the best
+    result search(State const& root, Ranges<action_type> const& actions,
+        int alpha = -infinity, int beta = infinity)
+    {
+        if(m_table && m_ages_table)
+            m_table->new_search();
+
+        m_depth = unlimited;
+        m_deadline = clock::time_point::max();
+        m_node_limit = std::numeric_limits<size_t>::max();
+        return run(root, actions, alpha, beta, std::nullopt);
+    }
+
+    result search(State const& root)
+    { return search(root, game_traits<State>::actions(root)); }
+
+    // searches 1, 2, 3... plies deep until it has seen every game end or
+    // the budget runs out, and returns the deepest search that finished.
+    // the time it takes past its budget is that of about 32 nodes
+    result search_within(State const& root,
+        Ranges<action_type> const& actions, budget const& b)
+    {
+        if(actions.size() == 0)
+            throw game_error("no actions to search");
+        if(m_table && m_ages_table)
+            m_table->new_search();
+
+        m_deadline = b.m_time < clock::time_point::max() - clock::now() ?
+            clock::now() + b.m_time : clock::time_point::max();
+
+        // not even one ply searched, any move is as good as another
+        result best{*actions.value_begin(), 0, 0, 0};
+        std::optional<action_type> hint;
+        size_t nodes = 0;
+
+        for(m_depth = 1; m_depth <= std::min(b.m_depth, unlimited); ++m_depth)
+        {
+            m_node_limit = b.m_nodes > nodes ? b.m_nodes - nodes : 0;
+            result r = run(root, actions, -infinity, infinity, hint);
+            nodes += r.m_nodes;
+            if(m_aborted)
+                break;
+
+            best = r;
+            hint = r.m_action;
+
+            // nothing more to see, or a win or loss that is certain
+            if(r.m_depth == unlimited || r.m_score > decided || 
+               r.m_score < -decided)
+                break;
+        }
+
+        best.m_nodes = nodes;
+        return best;
+    }
+
+    result search_within(State const& root, budget const& b)
+    { return search_within(root, game_traits<State>::actions(root), b); }
+
+    // forgets the killer moves, history scores and the table
+    void clear()
+    {
+        m_killers.clear();
+        m_history.clear();
+        m_stats = {};
+        if(m_table)
+            m_table->clear();
+    }
+
+    // nullptr when searching without one
+    table_type const* table() const
+    { return m_table.get(); }
+
+    // use of the table since construction or clear
+    table_type::statistics const& stats() const
+    { return m_stats; }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    // searches m_depth plies deep from root limited to actions, ordering
+    // hint first
+    result run(State const& root, Ranges<action_type> const& actions,
+        int alpha, int beta, std::optional<action_type> hint)
+    {
+        m_nodes = 1;
+        m_top = 0;
+        m_aborted = false;
+        m_next_check = check_interval;
+
+        if(actions.size() == 0)
+            throw game_error("no actions to search");
+
+        // the root is always searched, the table only orders its moves.
+        // it is not stored either, actions may be only some of its moves
+        std::uint64_t key = game_traits<State>::hash(root);
+        if(m_table && !hint)
+            if(auto e = probe(key))
+                hint = e->m_move;
+        push(root, key, actions, alpha, beta, hint);
+
+        int returned = 0; // the score of the child just searched
+        bool returned_horizon = false; // it depends on a guess
+        bool has_returned = false;
+
+        for(;;)
+        {
+            size_t ply = m_top - 1;
+            frame & f = m_stack[ply];
+
+            if(has_returned)
+            {
+                has_returned = false;
+                int score = -returned;
+                action_type action = f.m_actions[f.m_next - 1].second;
+                f.m_horizon = f.m_horizon || returned_horizon;
+
+                // a null window search that came out better than alpha
+                // is repeated with the full window
+                if(f.m_null_window && score > f.m_alpha && score < f.m_beta)
+                {
+                    f.m_null_window = false;
+                    if(enter(f.m_state, action, ply + 1, -f.m_beta,
+                        -f.m_alpha, returned, returned_horizon) != 
+                        entered::searching)
+                        has_returned = true;
+                    continue;
+                }
+
+                if(score > f.m_best)
+                {
+                    f.m_best = score;
+                    f.m_best_action = action;
+                }
+                if(score > f.m_alpha)
+                    f.m_alpha = score;
+                if(f.m_alpha >= f.m_beta)
+                {
+                    cutoff(f, ply, action);
+                    f.m_next = f.m_actions.size();
+                }
+            }
+
+            if(f.m_next == f.m_actions.size())
+            {
+                // every child searched or the rest cut off
+                if(m_top == 1)
+                    return {f.m_best_action, f.m_best, m_nodes,
+                            f.m_horizon ? m_depth : unlimited};
+                remember(f, ply);
+
+                returned = f.m_best;
+                returned_horizon = f.m_horizon;
+                has_returned = true;
+                --m_top;
+                continue;
+            }
+
+            if(over_budget())
+            {
+                // nothing on the stack is finished, nor stored
+                m_aborted = true;
+                return {action_type{}, 0, m_nodes, m_depth};
+            }
+
+            action_type action = f.m_actions[f.m_next++].second;
+            f.m_null_window = f.m_next > 1;
+            int alpha = f.m_null_window ? -f.m_alpha - 1 : -f.m_beta;
+
+            // may grow the stack, f is only used when it did not
+            entered e = enter(f.m_state, action, ply + 1, alpha, -f.m_alpha,
+                returned, returned_horizon);
+            if(e != entered::searching)
+            {
+                // a finished game is scored exactly, whatever the window,
+                // a bound from the table only for this one
+                if(e == entered::scored)
+                    f.m_null_window = false;
+                has_returned = true;
+            }
+        }
+    }
+
+    struct frame
+    {
+        State m_state;
+        std::uint64_t m_key;
+        // ordering keys and actions, best first
+        std::vector<std::pair<unsigned, action_type>> m_actions;
+        size_t m_next;
+        int m_alpha;
+        int m_alpha_entry; // alpha when the node was entered
+        int m_beta;
+        int m_best;
+        action_type m_best_action;
+        bool m_null_window; // the child being searched got a null window
+        bool m_horizon; // some state below was guessed at, not searched
+    };
+
+    using killer_moves = std::array<std::optional<action_type>, 2>;
+
+    // the depth of a table entry that saw every game end below it
+    static constexpr int exhaustive = table_type::max_depth;
+
+    // nodes between looks at the clock
+    static constexpr size_t check_interval = 32;
+
+    // wins and losses are stored as plies from the node, not the root
+    static constexpr int decided = win_score - 10'000;
+
+    static int to_table(int score, size_t ply)
+    {
+        if(score > decided)
+            return score + (int)ply;
+        if(score < -decided)
+            return score - (int)ply;
+        return score;
+    }
+
+    static int from_table(int score, size_t ply)
+    {
+        if(score > decided)
+            return score - (int)ply;
+        if(score < -decided)
+            return score + (int)ply;
+        return score;
+    }
+
+    enum class entered
+    {
+        searching, // a frame was pushed
+        bounded,   // returned is a bound from the table, good for the window
+        scored,    // returned is the exact score
+    };
+
+    // plies left to search below ply
+    int remaining(size_t ply) const
+    { return m_depth >= unlimited ? exhaustive : m_depth - (int)ply; }
+
+    bool over_budget()
+    {
+        if(m_nodes >= m_node_limit)
+            return true;
+        if(m_nodes < m_next_check || m_deadline == clock::time_point::max())
+            return false;
+
+        m_next_check = m_nodes + check_interval;
+        return clock::now() >= m_deadline;
+    }
+
+    // plays action and either scores the child in returned, from the table,
+    // because the game is over or by guessing at the search depth, or
+    // pushes a frame to search it.  horizon is set when returned depends
+    // on a guess
+    entered enter(State const& parent, action_type action, size_t ply,
+        int alpha, int beta, int & returned, bool & horizon)
+    {
+        State child = parent;
+        child(action);
+        ++m_nodes;
+
+        std::uint64_t key = game_traits<State>::hash(child);
+        std::optional<action_type> hint;
+        if(m_table)
+            if(auto e = probe(key))
+            {
+                int score = from_table(e->m_score, ply);
+                if(e->m_depth >= remaining(ply) &&
+                   (e->m_bound == bound::exact ||
+                    (e->m_bound == bound::lower && score >= beta) ||
+                    (e->m_bound == bound::upper && score <= alpha)))
+                {
+                    returned = score;
+                    horizon = e->m_depth < exhaustive;
+                    return e->m_bound == bound::exact ? entered::scored
+                                                      : entered::bounded;
+                }
+                hint = e->m_move;
+            }
+
+        auto actions = game_traits<State>::actions(child);
+        if(actions.size() == 0)
+        {
+            returned = terminal_score(child, ply);
+            horizon = false;
+            if(m_table)
+            {
+                ++m_stats.m_stores;
+                m_table->store(key, to_table(returned, ply), exhaustive,
+                    bound::exact, std::nullopt);
+            }
+            return entered::scored;
+        }
+
+        if(remaining(ply) <= 0)
+        {
+            // a guess is never mistaken for a certain win or loss
+            returned = std::clamp(game_traits<State>::evaluate(child),
+                -decided, decided);
+            horizon = true;
+            return entered::scored;
+        }
+
+        push(std::move(child), key, actions, alpha, beta, hint);
+        return entered::searching;
+    }
+
+    // stores what the search of f found out
+    void remember(frame const& f, size_t ply)
+    {
+        if(!m_table)
+            return;
+
+        bound b = f.m_best <= f.m_alpha_entry ? bound::upper
+                : f.m_best >= f.m_beta ? bound::lower
+                : bound::exact;
+        ++m_stats.m_stores;
+        m_table->store(f.m_key, to_table(f.m_best, ply),
+            f.m_horizon ? remaining(ply) : exhaustive, b, f.m_best_action);
+    }
+
+    std::optional<typename table_type::entry_value> probe(std::uint64_t key)
+    {
+        ++m_stats.m_probes;
+        auto e = m_table->probe(key);
+        if(e)
+            ++m_stats.m_hits;
+        return e;
+    }
+
+    void push(State state, std::uint64_t key,
+        Ranges<action_type> const& actions, int alpha, int beta,
+        std::optional<action_type> hint)
+    {
+        if(m_top == m_stack.size())
+            m_stack.emplace_back();
+        if(m_top == m_killers.size())
+            m_killers.emplace_back();
+
+        frame & f = m_stack[m_top];
+        f.m_state = std::move(state);
+        f.m_key = key;
+        f.m_next = 0;
+        f.m_alpha = alpha;
+        f.m_alpha_entry = alpha;
+        f.m_beta = beta;
+        f.m_best = -infinity;
+        f.m_null_window = false;
+        f.m_horizon = false;
+        order(f.m_actions, actions, hint, m_killers[m_top]);
+
+        ++m_top;
+    }
+
+    void order(std::vector<std::pair<unsigned, action_type>> & ordered,
+        Ranges<action_type> const& actions,
+        std::optional<action_type> const& hint, killer_moves const& killers)
+    {
+        ordered.clear();
+        for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+        {
+            unsigned key;
+            if(hint == *a)
+                key = ~0u;
+            else if(killers[0] == *a)
+                key = ~0u - 1;
+            else if(killers[1] == *a)
+                key = ~0u - 2;
+            else if(auto h = m_history.find(*a); h != m_history.end())
+                key = h->second;
+            else
+                key = 0;
+
+            // insertion sort, move lists are short and it keeps ties in
+            // the order the game listed them
+            ordered.emplace_back(key, *a);
+            for(size_t i = ordered.size() - 1;
+                i > 0 && ordered[i - 1].first < ordered[i].first; --i)
+                std::swap(ordered[i - 1], ordered[i]);
+        }
+    }
+
+    void cutoff(frame const& f, size_t ply, action_type action)
+    {
+        killer_moves & k = m_killers[ply];
+        if(k[0] != action)
+        {
+            k[1] = k[0];
+            k[0] = action;
+        }
+
+        // the number of actions at the node stands in for the depth left
+        unsigned depth = (unsigned)f.m_actions.size();
+        m_history[action] += depth * depth;
+    }
+
+    static int terminal_score(State const& state, size_t ply)
+    {
+        int score = game_traits<State>::score(state);
+        if(score > 0)
+            return win_score - (int)ply;
+        if(score < 0)
+            return (int)ply - win_score;
+        return 0;
+    }
+
+    std::vector<frame> m_stack;
+    size_t m_top = 0;
+    size_t m_nodes = 0;
+
+    std::vector<killer_moves> m_killers; // by ply
+    std::unordered_map<action_type, unsigned> m_history;
+    std::shared_ptr<table_type> m_table;
+    bool m_ages_table;
+    table_type::statistics m_stats;
+
+    // limits of the search under way
+    int m_depth = unlimited;
+    size_t m_node_limit = std::numeric_limits<size_t>::max();
+    clock::time_point m_deadline = clock::time_point::max();
+    size_t m_next_check = 0;
+    bool m_aborted = false;
+};
+
+// plays the best move alpha_beta_search finds, the table is kept from
+// one move to the next.  with a budget every move is searched within it
+template<typename State>
+class AlphaBetaInterface : public PlayerInterface<State> {
+public:
+    using action_type = game_traits<State>::action_type;
+    using search_type = alpha_beta_search<State>;
+    using budget = search_type::budget;
+
+    explicit AlphaBetaInterface(
+        size_t table_bytes = search_type::default_table_bytes) :
+        m_current{}, m_search{table_bytes}, m_budget{}
+    { }
+
+    explicit AlphaBetaInterface(budget const& b,
+        size_t table_bytes = search_type::default_table_bytes) :
+        m_current{}, m_search{table_bytes}, m_budget{b}
+    { }
+
+    virtual task<void> display(State const& state) override
+    {
+        m_current = state;
+        co_return;
+    }
+
+    virtual task<action_type>
+    select(Ranges<action_type> const& actions) override
+    {
+        auto result = m_budget ?
+            m_search.search_within(m_current, actions, *m_budget) :
+            m_search.search(m_current, actions);
+        m_nodes = result.m_nodes;
+        m_depth = result.m_depth;
+        co_return result.m_action;
+    }
+
+    // nodes visited by the last select
+    size_t nodes() const
+    { return m_nodes; }
+
+    // plies the last select looked ahead, search_type::unlimited when it
+    // saw every game end
+    int depth() const
+    { return m_depth; }
+
+    search_type const& search() const
+    { return m_search; }
+
+private:
+    State m_current;
+    search_type m_search;
+    std::optional<budget> m_budget;
+    size_t m_nodes = 0;
+    int m_depth = 0;
+};
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef __ASYNC_GENERATOR_HPP__
+#define __ASYNC_GENERATOR_HPP__
+
+#include "promise_allocator.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Asynchronous generator
+ *
+ * The producer is a coroutine that may co_await tasks, or anything else,
+ * between its co_yields.  The consumer awaits every element:
+ *
+ *     std::optional<T> value = co_await gen;   // nullopt once done
+ *
+ *     for(auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+ *         use(*it);
+ *
+ * Nothing is buffered.  The producer runs only while a consumer waits for
+ * the next element and suspends at every co_yield until the consumer asks
+ * again, so a slow consumer holds back the producer.  A yielded element
+ * lives in the producer's frame until then.
+ *
+ * Control passes back and forth by symmetric transfer.  When the producer
+ * awaits something that completes on another thread the consumer carries
+ * on there.
+ */
+template<typename T>
+class async_generator
+{
+public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+    using pointer = std::add_pointer_t<reference>;
+
+    class promise_type : public allocator_aware_promise<>
+    {
+    public:
+        promise_type() noexcept :
+            m_value{nullptr}, m_exception{}, m_consumer{}
+        { }
+
+        // hands control back to the waiting consumer
+        struct yield_awaiter
+        {
+            bool await_ready() const noexcept
+            { return false; }
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) const noexcept
+            { return h.promise().m_consumer; }
+
+            void await_resume() const noexcept
+            { }
+        };
+
+        async_generator get_return_object() noexcept
+        { return async_generator{
+            std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+        std::suspend_always initial_suspend() const noexcept
+        { return {}; }
+
+        yield_awaiter final_suspend() noexcept
+        {
+            m_value = nullptr;
+            return {};
+        }
+
+        void unhandled_exception() noexcept
+        { m_exception = std::current_exception(); }
+
+        void return_void() noexcept
+        { }
+
+        // a yielded temporary lives until the producer is resumed
+        yield_awaiter yield_value(reference value) noexcept
+            requires std::is_reference_v<T>
+        {
+            m_value = std::addressof(value);
+            return {};
+        }
+
+        // an rvalue is the consumer's to move from
+        yield_awaiter yield_value(value_type && value) noexcept
+            requires (!std::is_reference_v<T>)
+        {
+            m_value = std::addressof(value);
+            return {};
+        }
+
+        // an lvalue stays the producer's, the consumer gets a copy
+        auto yield_value(value_type const& value)
+            noexcept(std::is_nothrow_copy_constructible_v<value_type>)
+            requires (!std::is_reference_v<T>)
+        { return converted_awaiter{{}, value}; }
+
+        // anything else is first converted into the awaiter which stays in
+        // the producer frame while it is suspended
+        template<typename From>
+            requires (!std::is_reference_v<T> &&
+                      std::is_constructible_v<value_type, From>)
+        auto yield_value(From && from)
+            noexcept(std::is_nothrow_constructible_v<value_type, From>)
+        { return converted_awaiter{{}, value_type(std::forward<From>(from))}; }
+
+    private:
+        struct converted_awaiter : yield_awaiter
+        {
+            value_type m_converted;
+
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) noexcept
+            {
+                h.promise().m_value = std::addressof(m_converted);
+                return yield_awaiter::await_suspend(h);
+            }
+        };
+
+        friend async_generator;
+
+        pointer m_value; // nullptr once the producer has finished
+        std::exception_ptr m_exception;
+        std::coroutine_handle<> m_consumer;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    // resumes the producer until its next element or its end
+    struct advance_awaiter
+    {
+        bool await_ready() const noexcept
+        { return !m_coro || m_coro.done(); }
+
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<> consumer) noexcept
+        {
+            m_coro.promise().m_consumer = consumer;
+            return m_coro;
+        }
+
+        // true while there is an element
+        bool await_resume() const
+        {
+            if(!m_coro)
+                return false;
+
+            auto & p = m_coro.promise();
+            if(p.m_exception)
+                std::rethrow_exception(std::exchange(p.m_exception, nullptr));
+
+            return p.m_value != nullptr;
+        }
+
+        handle_type m_coro;
+    };
+
+    struct next_awaiter : advance_awaiter
+    {
+        std::optional<value_type> await_resume() const
+        {
+            if(!advance_awaiter::await_resume())
+                return std::nullopt;
+            return std::optional<value_type>{
+                std::move(*this->m_coro.promise().m_value)};
+        }
+    };
+
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = async_generator::value_type;
+        using reference = async_generator::reference;
+        using pointer = async_generator::pointer;
+
+        iterator() noexcept : m_coro{} { }
+
+        reference operator*() const noexcept
+        { return *m_coro.promise().m_value; }
+
+        pointer operator->() const noexcept
+        { return m_coro.promise().m_value; }
+
+        struct increment_awaiter : advance_awaiter
+        {
+            iterator & await_resume() const
+            {
+                if(!advance_awaiter::await_resume())
+                    m_it->m_coro = nullptr;
+                return *m_it;
+            }
+
+            iterator * m_it;
+        };
+
+        // co_await ++it
+        increment_awaiter operator++() noexcept
+        { return increment_awaiter{{m_coro}, this}; }
+
+        bool operator==(std::default_sentinel_t) const noexcept
+        { return !m_coro; }
+
+    private:
+        friend async_generator;
+
+        explicit iterator(handle_type coro) noexcept : m_coro{coro} { }
+
+        handle_type m_coro; // null at the end
+    };
+
+    struct begin_awaiter : advance_awaiter
+    {
+        iterator await_resume() const
+        {
+            if(!advance_awaiter::await_resume())
+                return iterator{};
+            return iterator{this->m_coro};
+        }
+    };
+
+    // co_await gen.begin(), runs the producer to its first element
+    begin_awaiter begin() noexcept
+    { return begin_awaiter{{m_coro}}; }
+
+    std::default_sentinel_t end() const noexcept
+    { return std::default_sentinel; }
+
+    // the next element, nullopt once the producer is done
+    next_awaiter next() noexcept
+    { return next_awaiter{{m_coro}}; }
+
+    next_awaiter operator co_await() noexcept
+    { return next(); }
+
+    bool done() const noexcept
+    { return !m_coro || m_coro.done(); }
+
+    async_generator(async_generator && g) noexcept :
+        m_coro{std::exchange(g.m_coro, nullptr)}
+    { }
+
+    async_generator & operator=(async_generator && g) noexcept
+    {
+        if(this == &g)
+            return *this;
+        if(m_coro)
+            m_coro.destroy();
+        m_coro = std::exchange(g.m_coro, nullptr);
+        return *this;
+    }
+
+    ~async_generator()
+    {
+        if(m_coro)
+            m_coro.destroy();
+    }
+
+private:
+    explicit async_generator(handle_type h) noexcept : m_coro{h} { }
+
+    handle_type m_coro;
+};
+
+#endif
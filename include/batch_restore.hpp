@@ -0,0 +1,167 @@
+#ifndef __BATCH_RESTORE_HPP__
+#define __BATCH_RESTORE_HPP__
+
+#include "saveable_coroutine.hpp"
+#include "snapshot_archive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+/**
+ * Batch restore
+ *
+ * Restores many coroutines at once across a set of threads.  The caller
+ * supplies args_for(i), returning a tuple of lvalue references (std::tie)
+ * to the arguments the i-th coroutine is hydrated with.  args_for is
+ * called concurrently from the restoring threads.  Hydration rebinds
+ * suspend_aware arguments to the restored frame, so every coroutine must
+ * get its own argument objects.
+ *
+ * Frames are allocated by the restoring threads, with the default pooled
+ * allocator they end up in those threads' free lists once destroyed.
+ */
+
+// calls restore(i) for i in [0, count) on thread_count threads, handing out
+// indices in chunks.  the first exception thrown stops the batch and is
+// rethrown once every thread has finished.
+template<typename Restore>
+void parallel_restore(size_t count, size_t thread_count, Restore && restore)
+{
+    static constexpr size_t chunk_size = 64;
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&]() {
+        while(!failed.load(std::memory_order_relaxed))
+        {
+            size_t begin = next.fetch_add(chunk_size,
+                std::memory_order_relaxed);
+            if(begin >= count)
+                break;
+
+            size_t end = std::min(begin + chunk_size, count);
+            try {
+                for(size_t i = begin; i < end; ++i)
+                    restore(i);
+            } catch(...) {
+                std::lock_guard lock(error_mutex);
+                if(!error)
+                    error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    thread_count = std::max<size_t>(1,
+        std::min(thread_count, (count + chunk_size - 1) / chunk_size));
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(thread_count - 1);
+        for(size_t t = 1; t < thread_count; ++t)
+            threads.emplace_back(worker);
+
+        // the calling thread works too
+        worker();
+    }
+
+    if(error)
+        std::rethrow_exception(error);
+}
+
+// destroys whatever part of a batch was restored before it failed
+inline void destroy_restored(std::vector<void*> & addresses)
+{
+    for(void * address : addresses)
+        while(address != nullptr)
+        {
+            void * child =
+                saveable_promise<void>::header_from(address)->child_address;
+            std::coroutine_handle<>::from_address(address).destroy();
+            address = child;
+        }
+    addresses.clear();
+}
+
+template<typename HandleType, typename Load>
+std::vector<saveable<HandleType>> batch_restore(size_t count,
+    size_t thread_count, Load && load)
+{
+    std::vector<void*> addresses(count, nullptr);
+
+    try {
+        parallel_restore(count, thread_count, [&](size_t i) {
+            addresses[i] = load(i).address();
+        });
+    } catch(...) {
+        destroy_restored(addresses);
+        throw;
+    }
+
+    std::vector<saveable<HandleType>> restored;
+    restored.reserve(count);
+    for(void * address : addresses)
+        restored.emplace_back(address);
+
+    return restored;
+}
+
+// restores every coroutine of an archive, in index order
+template<typename HandleType, typename ArgsFor>
+std::vector<saveable<HandleType>> restore_all(
+    snapshot_archive_view const & archive, size_t thread_count,
+    ArgsFor && args_for)
+{
+    auto entries = archive.entries();
+
+    return batch_restore<HandleType>(entries.size(), thread_count,
+        [&](size_t i) {
+            return std::apply([&](auto &... args) {
+                return archive.load<HandleType>(entries[i].id, args...);
+            }, args_for(i));
+        });
+}
+
+// restores every coroutine of an archive in place, in index order
+template<typename HandleType, typename ArgsFor>
+std::vector<saveable<HandleType>> restore_all_in_place(
+    snapshot_archive_view const & archive, size_t thread_count,
+    ArgsFor && args_for)
+{
+    auto entries = archive.entries();
+
+    return batch_restore<HandleType>(entries.size(), thread_count,
+        [&](size_t i) {
+            return std::apply([&](auto &... args) {
+                return archive.load_in_place<HandleType>(entries[i].id,
+                    args...);
+            }, args_for(i));
+        });
+}
+
+// restores one coroutine from each stream, every stream is read by a
+// single thread
+template<typename HandleType, typename ArgsFor>
+std::vector<saveable<HandleType>> restore_all(
+    std::span<std::istream * const> streams, size_t thread_count,
+    ArgsFor && args_for)
+{
+    return batch_restore<HandleType>(streams.size(), thread_count,
+        [&](size_t i) {
+            return std::apply([&](auto &... args) {
+                return load_coro<HandleType>(*streams[i], args...);
+            }, args_for(i));
+        });
+}
+
+#endif
@@ -0,0 +1,314 @@
+#ifndef __CHECKPOINT_WRITER_HPP__
+#define __CHECKPOINT_WRITER_HPP__
+
+#include "saveable_coroutine.hpp"
+#include "snapshot_archive.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Checkpoint log
+ *
+ * An append-only file of checkpoint records
+ *
+ *     | checkpoint_record | snapshot |
+ *
+ * where a later record of an id supersedes the earlier ones.  Snapshots
+ * stay aligned to frame_alignment within the file.
+ */
+static constexpr inline std::uint64_t checkpoint_record_magic =
+    0x31'44'52'43'4b'50'43'53; // "SCPKCRD1"
+
+struct checkpoint_record
+{
+    std::uint64_t magic;
+    snapshot_id id;
+    std::uint64_t sequence;
+    std::uint64_t size; // of the snapshot that follows
+};
+
+static_assert(sizeof(checkpoint_record) % frame_alignment == 0,
+    "snapshots must stay aligned in a checkpoint log");
+
+/**
+ * Background checkpoint writer
+ *
+ * checkpoint() only copies the frame chain into a pre-allocated staging
+ * buffer and returns.  The lock is held just to reserve a slot in the
+ * buffer, the copy itself runs outside it so checkpoints of several
+ * threads are copied in parallel.  A dedicated thread waits for the copies
+ * in flight, swaps the staging buffer for an empty one and appends
+ * everything staged since its last write to the log with one write and one
+ * fdatasync, so checkpoints arriving while the disk is busy share a single
+ * sync.
+ *
+ * When both buffers are full checkpoint() waits for the writer,
+ * try_checkpoint() gives up instead.
+ */
+class checkpoint_writer
+{
+public:
+    explicit checkpoint_writer(std::string const & path,
+        size_t staging_capacity = 16 << 20) :
+        m_fd{-1}, m_capacity{staging_capacity}, m_staging{}, m_writing{},
+        m_staged_size{0}, m_copying{0}, m_sequence{0}, m_written{0}, 
+        m_syncs{0}, m_error{}, m_stopping{false}
+    {
+        m_fd = ::open(path.c_str(),
+            O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if(m_fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+
+        // sized up front so reserving a slot never touches its bytes
+        m_staging.resize(m_capacity);
+        m_writing.resize(m_capacity);
+
+        m_thread = std::jthread(&checkpoint_writer::writer, this);
+    }
+
+    checkpoint_writer(checkpoint_writer const &) = delete;
+    checkpoint_writer & operator=(checkpoint_writer const &) = delete;
+
+    // writes out everything staged before stopping
+    ~checkpoint_writer()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_staged.notify_all();
+        m_thread.join();
+        ::close(m_fd);
+    }
+
+    // stages a checkpoint of coroutine, returns its sequence number
+    std::uint64_t checkpoint(snapshot_id id, saveable_base const & coroutine)
+    { return stage(id, coroutine, true); }
+
+    // stages a checkpoint unless the staging buffer is full, returns its
+    // sequence number or 0
+    std::uint64_t try_checkpoint(snapshot_id id,
+        saveable_base const & coroutine)
+    { return stage(id, coroutine, false); }
+
+    // waits until every checkpoint staged so far is on disk
+    void flush()
+    {
+        std::unique_lock lock(m_mutex);
+        std::uint64_t sequence = m_sequence;
+        m_staged.notify_one();
+        m_synced.wait(lock, [&]{
+            return m_written >= sequence || m_error;
+        });
+        rethrow();
+    }
+
+    // number of fdatasync calls so far
+    std::uint64_t syncs() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_syncs;
+    }
+
+private:
+    std::uint64_t stage(snapshot_id id, saveable_base const & coroutine,
+        bool wait)
+    {
+        size_t size = coroutine.snapshot_size();
+        size_t total = sizeof(checkpoint_record) + size;
+        if(total > m_capacity)
+            throw std::logic_error("checkpoint larger than the staging "
+                                   "buffer");
+
+        std::unique_lock lock(m_mutex);
+        rethrow();
+
+        if(m_staged_size + total > m_capacity)
+        {
+            if(!wait)
+                return 0;
+
+            m_staged.notify_one();
+            m_synced.wait(lock, [&]{
+                return m_staged_size + total <= m_capacity || m_error;
+            });
+            rethrow();
+        }
+
+        checkpoint_record record = {
+            .magic = checkpoint_record_magic,
+            .id = id,
+            .sequence = ++m_sequence,
+            .size = size,
+        };
+
+        // reserve the slot, the writer leaves the buffer alone until every
+        // copy into it is done
+        char * slot = m_staging.data() + m_staged_size;
+        m_staged_size += total;
+        ++m_copying;
+        lock.unlock();
+
+        std::memcpy(slot, &record, sizeof(record));
+        coroutine.save(slot + sizeof(record));
+
+        lock.lock();
+        --m_copying;
+        lock.unlock();
+        m_staged.notify_one();
+
+        return record.sequence;
+    }
+
+    void writer()
+    {
+        std::unique_lock lock(m_mutex);
+        for(;;)
+        {
+            m_staged.wait(lock, [this]{
+                return (m_staged_size > 0 || m_stopping) && m_copying == 0;
+            });
+
+            if(m_staged_size == 0)
+                break;
+
+            // take everything staged so far
+            std::swap(m_staging, m_writing);
+            size_t size = std::exchange(m_staged_size, 0);
+            std::uint64_t sequence = m_sequence;
+            lock.unlock();
+            m_synced.notify_all();
+
+            std::exception_ptr error;
+            try {
+                write_all(m_writing.data(), size);
+                if(::fdatasync(m_fd) < 0)
+                    throw std::system_error(errno, std::generic_category(),
+                        "fdatasync");
+            } catch(...) {
+                error = std::current_exception();
+            }
+
+            lock.lock();
+            m_written = sequence;
+            ++m_syncs;
+            if(error && !m_error)
+                m_error = error;
+            m_synced.notify_all();
+        }
+    }
+
+    void write_all(char const * data, size_t size)
+    {
+        while(size > 0)
+        {
+            ssize_t written = ::write(m_fd, data, size);
+            if(written < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(),
+                    "write");
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    // must hold m_mutex
+    void rethrow()
+    {
+        if(m_error)
+            std::rethrow_exception(m_error);
+    }
+
+    int m_fd;
+    size_t m_capacity;
+
+    std::vector<char> m_staging; // filled by checkpoint
+    std::vector<char> m_writing; // owned by the writer thread
+    size_t m_staged_size;        // of m_staging, reserved so far
+    size_t m_copying;            // checkpoints copying into their slot
+
+    std::uint64_t m_sequence;    // last staged
+    std::uint64_t m_written;     // last synced
+    std::uint64_t m_syncs;
+    std::exception_ptr m_error;
+    bool m_stopping;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_staged;
+    std::condition_variable m_synced;
+    std::jthread m_thread;
+};
+
+// reads a checkpoint log and restores the latest checkpoint of an id
+class checkpoint_log_reader
+{
+public:
+    explicit checkpoint_log_reader(std::istream & is) :
+        m_is{is}, m_latest{}
+    {
+        auto base = is.tellg();
+        m_is.seekg(0, std::ios::end);
+        auto end = m_is.tellg();
+        m_is.seekg(base);
+
+        checkpoint_record record;
+        while(m_is.read(reinterpret_cast<char*>(&record), sizeof(record)))
+        {
+            if(record.magic != checkpoint_record_magic)
+                throw std::logic_error("not a checkpoint log");
+
+            // a record torn by a crash ends the log, the earlier
+            // checkpoint of its id stays the latest
+            auto at = m_is.tellg();
+            if(record.size > std::uint64_t(end - at))
+                break;
+
+            m_latest[record.id] = at - base;
+            m_is.seekg(record.size, std::ios::cur);
+        }
+
+        m_is.clear();
+        m_base = base;
+    }
+
+    bool contains(snapshot_id id) const
+    { return m_latest.contains(id); }
+
+    size_t size() const
+    { return m_latest.size(); }
+
+    template<typename HandleType, typename... ArgTypes>
+    saveable<HandleType> load(snapshot_id id, ArgTypes &... args)
+    {
+        auto i = m_latest.find(id);
+        if(i == m_latest.end())
+            throw std::logic_error("unknown snapshot id");
+
+        m_is.clear();
+        m_is.seekg(m_base + std::streamoff(i->second));
+        return load_coro<HandleType>(m_is, args...);
+    }
+
+private:
+    std::istream & m_is;
+    std::istream::pos_type m_base;
+    std::unordered_map<snapshot_id, std::uint64_t> m_latest;
+};
+
+#endif
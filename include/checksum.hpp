@@ -0,0 +1,89 @@
+#ifndef __CHECKSUM_HPP__
+#define __CHECKSUM_HPP__
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+using std::size_t;
+
+using crc32c_table_set = std::array<std::array<std::uint32_t, 256>, 8>;
+
+// slicing-by-8 tables, t[0] is the bytewise table and t[k] advances t[k - 1]
+// by one more byte
+static constexpr crc32c_table_set make_crc32c_tables(std::uint32_t polynomial)
+{
+    crc32c_table_set t{};
+    for(std::uint32_t i = 0; i < 256; ++i)
+    {
+        std::uint32_t crc = i;
+        for(int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (crc & 1 ? polynomial : 0);
+        t[0][i] = crc;
+    }
+
+    for(size_t k = 1; k < 8; ++k)
+        for(size_t i = 0; i < 256; ++i)
+            t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+
+    return t;
+}
+
+static constexpr inline crc32c_table_set crc32c_tables = 
+    make_crc32c_tables(0x82f63b78); // reflected Castagnoli polynomial
+
+/**
+ * CRC32C (Castagnoli), the checksum of snapshot frames.
+ *
+ * Uses the SSE4.2 crc32 instruction when the target has it and a
+ * slicing-by-8 table otherwise, both give the same result.  Checksums
+ * chain: crc32c(crc32c(0, a), b) == crc32c(0, a + b).
+ */
+struct crc32c
+{
+    static std::uint32_t update(std::uint32_t crc, void const * data,
+        size_t size)
+    {
+        auto p = static_cast<unsigned char const *>(data);
+        crc = ~crc;
+
+#if defined(__SSE4_2__)
+        for(; size >= 8; size -= 8, p += 8)
+        {
+            std::uint64_t v;
+            std::memcpy(&v, p, sizeof(v));
+            crc = (std::uint32_t)_mm_crc32_u64(crc, v);
+        }
+        for(; size > 0; --size)
+            crc = _mm_crc32_u8(crc, *p++);
+#else
+        auto const & t = crc32c_tables;
+        for(; size >= 8; size -= 8, p += 8)
+        {
+            std::uint32_t lo, hi;
+            std::memcpy(&lo, p, sizeof(lo));
+            std::memcpy(&hi, p + 4, sizeof(hi));
+            lo ^= crc;
+
+            crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+                  t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+                  t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+                  t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        }
+        for(; size > 0; --size)
+            crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+#endif
+
+        return ~crc;
+    }
+
+    static std::uint32_t compute(void const * data, size_t size)
+    { return update(0, data, size); }
+};
+
+#endif
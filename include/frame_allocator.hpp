@@ -0,0 +1,160 @@
+#ifndef __FRAME_ALLOCATOR_HPP__
+#define __FRAME_ALLOCATOR_HPP__
+
+#include <new>
+#include <array>
+#include <cstddef>
+
+using std::size_t;
+
+/**
+ * Frame allocators are stateless types providing
+ *
+ *     static void * allocate(size_t size);
+ *     static void deallocate(void * mem, size_t size);
+ *
+ * where size is the full size of the frame including its frame_header.
+ * deallocate is always called with the same size passed to allocate.
+ */
+
+// goes straight to the global heap
+struct heap_frame_allocator
+{
+    static void * allocate(size_t size)
+    { return ::operator new(size); }
+
+    static void deallocate(void * mem, size_t size)
+    { ::operator delete(mem, size); }
+};
+
+// size-class pooled allocator
+//
+// frames are rounded up to a multiple of Granularity and recycled through
+// thread-local free lists, one list per size class.  frames larger than
+// MaxSize go to the global heap.  each list caches at most MaxCached
+// blocks, anything beyond that is returned to the heap.
+//
+// a block freed on a different thread than it was allocated on simply
+// joins the freeing thread's list since every block is an independent
+// heap allocation.
+template<size_t Granularity = 64, size_t MaxSize = 4096,
+         size_t MaxCached = 256>
+struct pooled_frame_allocator
+{
+    static_assert(Granularity >= sizeof(void*),
+        "granularity must fit a free list link");
+    static_assert(MaxSize % Granularity == 0,
+        "max size must be a multiple of the granularity");
+
+    static constexpr size_t class_count = MaxSize / Granularity;
+
+    // 1-based size class, 0 or > class_count are not pooled
+    static constexpr size_t size_class(size_t size)
+    { return (size + Granularity - 1) / Granularity; }
+
+    static void * allocate(size_t size)
+    {
+        size_t c = size_class(size);
+        if(c == 0 || c > class_count)
+            return ::operator new(size);
+
+        if(destroyed())
+            return ::operator new(c * Granularity);
+
+        free_list & list = cache().m_lists[c - 1];
+        if(list.m_head == nullptr)
+            return ::operator new(c * Granularity);
+
+        free_block * block = list.m_head;
+        list.m_head = block->m_next;
+        --list.m_count;
+        return block;
+    }
+
+    static void deallocate(void * mem, size_t size)
+    {
+        size_t c = size_class(size);
+        if(c == 0 || c > class_count)
+            return ::operator delete(mem, size);
+
+        // the cache of this thread is already gone (frames destroyed
+        // during thread or program exit)
+        if(destroyed())
+            return ::operator delete(mem, c * Granularity);
+
+        free_list & list = cache().m_lists[c - 1];
+        if(list.m_count >= MaxCached)
+            return ::operator delete(mem, c * Granularity);
+
+        list.m_head = ::new(mem) free_block{list.m_head};
+        ++list.m_count;
+    }
+
+    // returns every cached block of the calling thread to the heap
+    static void release()
+    {
+        if(!destroyed())
+            cache().release();
+    }
+
+    // number of blocks cached by the calling thread
+    static size_t cached()
+    {
+        if(destroyed())
+            return 0;
+
+        size_t count = 0;
+        for(auto const & list : cache().m_lists)
+            count += list.m_count;
+        return count;
+    }
+
+private:
+    struct free_block { free_block * m_next; };
+
+    struct free_list
+    {
+        free_block * m_head = nullptr;
+        size_t m_count = 0;
+    };
+
+    struct thread_cache
+    {
+        void release()
+        {
+            for(size_t c = 0; c < class_count; ++c)
+            {
+                free_list & list = m_lists[c];
+                while(list.m_head != nullptr)
+                {
+                    free_block * block = list.m_head;
+                    list.m_head = block->m_next;
+                    ::operator delete(block, (c + 1) * Granularity);
+                }
+                list.m_count = 0;
+            }
+        }
+
+        ~thread_cache()
+        {
+            release();
+            destroyed() = true;
+        }
+
+        std::array<free_list, class_count> m_lists{};
+    };
+
+    static thread_cache & cache()
+    {
+        thread_local thread_cache s_cache;
+        return s_cache;
+    }
+
+    static bool & destroyed()
+    {
+        thread_local bool s_destroyed = false;
+        return s_destroyed;
+    }
+};
+
+#endif
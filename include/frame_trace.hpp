@@ -0,0 +1,211 @@
+#ifndef __FRAME_TRACE_HPP__
+#define __FRAME_TRACE_HPP__
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <ostream>
+#include <cstddef>
+
+using std::size_t;
+
+enum class frame_event : unsigned char {
+    allocate,              // saveable_promise::operator new
+    restore,               // frame allocated from a saved header
+    deallocate,            // saveable_promise::operator delete
+    construct,             // promise constructed by a coroutine call
+    construct_from_header, // promise constructed from a saved header
+    default_construct,
+    destruct,
+};
+
+inline char const * to_string(frame_event event)
+{
+    switch(event) {
+    case frame_event::allocate: return "allocate";
+    case frame_event::restore: return "restore";
+    case frame_event::deallocate: return "deallocate";
+    case frame_event::construct: return "construct";
+    case frame_event::construct_from_header: return "construct_from_header";
+    case frame_event::default_construct: return "default_construct";
+    case frame_event::destruct: return "destruct";
+    }
+    return "unknown";
+}
+
+struct frame_trace_record
+{
+    long long timestamp; // steady_clock ticks
+    void const * address;
+    size_t size;
+    frame_event event;
+};
+
+inline std::ostream & operator<<(std::ostream & os,
+    frame_trace_record const & record)
+{
+    return os << record.timestamp << " " << to_string(record.event) << " "
+              << record.address << " " << record.size;
+}
+
+/**
+ * Frame trace policies are stateless types providing
+ *
+ *     static constexpr bool enabled;
+ *     static void record(frame_event, void const * address, size_t size);
+ *
+ * selected through saveable_traits<HandleType>::trace_type.
+ */
+
+// compiles to nothing
+struct null_frame_trace
+{
+    static constexpr bool enabled = false;
+
+    static void record(frame_event, void const *, size_t = 0) noexcept
+    { }
+};
+
+// records events into a fixed size ring buffer owned by the calling thread
+//
+// recording never locks: every thread writes only into its own ring.  rings
+// are kept on a global push-only list and handed to a new thread when their
+// owner exits, so the events of finished threads can still be dumped.
+// dump_all reads the rings of other threads and should only be called once
+// they have stopped recording.
+template<size_t Capacity = 4096>
+struct ring_frame_trace
+{
+    static constexpr bool enabled = true;
+
+    static void record(frame_event event, void const * address,
+        size_t size = 0) noexcept
+    {
+        ring * r = local().m_ring;
+        if(r == nullptr)
+            return;
+
+        size_t head = r->m_head.load(std::memory_order_relaxed);
+        r->m_records[head % Capacity] = {
+            .timestamp = std::chrono::steady_clock::now()
+                .time_since_epoch().count(),
+            .address = address,
+            .size = size,
+            .event = event,
+        };
+        r->m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // events recorded by the calling thread, oldest first
+    static std::vector<frame_trace_record> snapshot()
+    {
+        std::vector<frame_trace_record> records;
+        if(ring * r = local().m_ring)
+            r->copy_to(records);
+        return records;
+    }
+
+    // every event still held by any ring, grouped by ring
+    static std::vector<frame_trace_record> snapshot_all()
+    {
+        std::vector<frame_trace_record> records;
+        for(ring * r = s_rings.load(std::memory_order_acquire); r != nullptr;
+            r = r->m_next)
+            r->copy_to(records);
+        return records;
+    }
+
+    static void dump(std::ostream & os)
+    {
+        for(auto const & record : snapshot())
+            os << record << "\n";
+    }
+
+    static void dump_all(std::ostream & os)
+    {
+        for(auto const & record : snapshot_all())
+            os << record << "\n";
+    }
+
+    // forgets the events of the calling thread
+    static void clear()
+    {
+        if(ring * r = local().m_ring)
+            r->m_tail = r->m_head.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct ring
+    {
+        void copy_to(std::vector<frame_trace_record> & records) const
+        {
+            size_t head = m_head.load(std::memory_order_acquire);
+            size_t tail = m_tail;
+            if(head - tail > Capacity)
+                tail = head - Capacity;
+
+            for(; tail != head; ++tail)
+                records.push_back(m_records[tail % Capacity]);
+        }
+
+        std::array<frame_trace_record, Capacity> m_records{};
+        std::atomic<size_t> m_head{0};
+        size_t m_tail = 0;
+        std::atomic<bool> m_owned{true};
+        ring * m_next = nullptr;
+    };
+
+    // claims a ring for the lifetime of the calling thread
+    struct ring_owner
+    {
+        ring_owner() : m_ring{nullptr}
+        {
+            // reuse the ring of a thread that has exited
+            for(ring * r = s_rings.load(std::memory_order_acquire);
+                r != nullptr; r = r->m_next)
+            {
+                bool owned = false;
+                if(r->m_owned.compare_exchange_strong(owned, true))
+                {
+                    m_ring = r;
+                    return;
+                }
+            }
+
+            // rings are never freed, they are recycled between threads
+            m_ring = new ring{};
+            m_ring->m_next = s_rings.load(std::memory_order_relaxed);
+            while(!s_rings.compare_exchange_weak(m_ring->m_next, m_ring,
+                std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+
+        ~ring_owner()
+        {
+            if(m_ring != nullptr)
+                m_ring->m_owned.store(false, std::memory_order_release);
+            m_ring = nullptr;
+        }
+
+        ring * m_ring;
+    };
+
+    static ring_owner & local()
+    {
+        thread_local ring_owner s_owner;
+        return s_owner;
+    }
+
+    static inline std::atomic<ring*> s_rings{nullptr};
+};
+
+// define SAVEABLE_COROUTINE_TRACE to record frame lifecycle events of every
+// saveable coroutine that does not select its own trace_type
+#ifdef SAVEABLE_COROUTINE_TRACE
+using default_frame_trace = ring_frame_trace<>;
+#else
+using default_frame_trace = null_frame_trace;
+#endif
+
+#endif
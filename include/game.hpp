@@ -3,14 +3,17 @@
 
 #include "ranges.hpp"
 #include "task.hpp"
+#include "async_generator.hpp"
+#include "generator.hpp"
+#include "thread_pool.hpp"
+#include "scheduler.hpp"
+#include "when_all.hpp"
 
 #include <stdexcept>
-#include <thread>
 #include <concepts>
-#include <mutex>
-#include <condition_variable>
-#include <list>
+#include <cstdint>
 #include <functional>
+#include <vector>
 
 // DEBUG
 #include <iostream>
@@ -24,6 +27,42 @@ struct game_traits
     using action_type = typename T::action_type;
     static Ranges<action_type> actions(T const& game)
     { return game.actions(); }
+
+    // the value of a finished game to the player to move, above 0 a win,
+    // below a loss.  a game without score() is lost by whoever runs out
+    // of moves
+    static int score(T const& game)
+    {
+        if constexpr(requires {
+            { game.score() } -> std::convertible_to<int>; })
+            return game.score();
+        else
+            return -1;
+    }
+
+    // a guess at the value of an unfinished game to the player to move,
+    // for searches that stop short of the end, from evaluate() when the
+    // game has one.  a game without it looks like a draw
+    static int evaluate(T const& game)
+    {
+        if constexpr(requires {
+            { game.evaluate() } -> std::convertible_to<int>; })
+            return game.evaluate();
+        else
+            return 0;
+    }
+
+    // a 64-bit key of the state for transposition tables, from hash() when
+    // the game has one and std::hash otherwise.  a game should keep it up
+    // to date as it is played, with zobrist_keys, so this is O(1)
+    static std::uint64_t hash(T const& game)
+    {
+        if constexpr(requires {
+            { game.hash() } -> std::convertible_to<std::uint64_t>; })
+            return game.hash();
+        else
+            return std::hash<T>{}(game);
+    }
 };
 
 template<typename State>
@@ -62,10 +101,16 @@ struct GameInterface {
     virtual task<List<player_type*>> players() 
     { co_return m_players; }
 
+    // every player's display is started before any is awaited, the game
+    // resumes once when the last one finishes
     virtual task<void> display(State const& state) 
     {
+        std::vector<task<void>> displays;
+        displays.reserve(m_players.size());
         for(auto const& p : m_players)
-            co_await p->display(state);
+            displays.push_back(p->display(state));
+
+        co_await when_all(std::move(displays));
     }
 
     void add_player(player_type & player)
@@ -94,153 +139,52 @@ private:
     std::vector<player_type*> m_players;
 };
 
+// sends the state to every player on a work-stealing pool
+//
+// display suspends the game while the players are updated and the last
+// display to finish resumes it on its pool thread, so a game driven by
+// turn_based moves between threads; wait for it with sync_wait rather
+// than task::get.
 template<typename State>
 struct ThreadedGame : public GameInterface<State> 
 {
-    using work_type = std::function<void()>;
-    using work_list_type = std::list<work_type>;
     using player_type = GameInterface<State>::player_type;
 
     virtual task<void> display(State const& state) override
     {
-        std::mutex local_mutex;
-        std::condition_variable_any local_cond;
-
-        std::unique_lock local_lock(local_mutex);
-        std::unique_lock lock(m_mutex);
-
-        // use the workers to send the state to the players as quickly as 
-        // possible
-        size_t player_count = 0;
+        std::vector<task<void>> displays;
+        displays.reserve(GameInterface<State>::players_size());
         for(auto * player : GameInterface<State>::players_view())
-        {
-            ++player_count;
-
-            add_work([player, &state, &local_lock, &local_cond, &player_count]() 
-            {
-                auto task = player->display(state);
-                task.get(); // this is a coroutine
-
-                local_lock.lock();
-                --player_count;
-                local_lock.unlock();
-                local_cond.notify_one();
-            }); 
-        }
-
-        lock.unlock();
-        m_cond.notify_all();
+            displays.push_back(player->display(state));
 
-        local_cond.wait(local_lock, [&]() { return player_count == 0; });
-        co_return;
+        co_await when_all(m_scheduler, std::move(displays));
     }
 
     virtual void start()
     { }
 
     virtual void stop()
-    { m_stopper.request_stop(); }
-
+    { }
 
     ThreadedGame(size_t thread_count) : 
-        GameInterface<State>{}, m_threads(thread_count)
-    { 
-        for(auto *& thread : m_threads)
-            startup(thread);
-            
-        start();
-    }
+        GameInterface<State>{}, m_pool{thread_count}, m_scheduler{m_pool}
+    { start(); }
 
     ~ThreadedGame() 
-    { 
-        stop();
-        for(auto *& thread : m_threads)
-            shutdown(thread);
-        m_threads.clear();
-    }
+    { stop(); }
 
-
-protected:
-    void startup(std::jthread *& thread)
-    { 
-        // HACK: assumes a vector container
-        size_t id = std::distance(&m_threads[0], &thread);
-
-        thread = new std::jthread(&ThreadedGame::worker, this,
-            id, m_stopper.get_token()); 
-    }
-
-    void shutdown(std::jthread *& thread)
-    { 
-        delete thread; 
-        thread = nullptr;
-    }
-
-    void worker(size_t id, std::stop_token stoken)
-    {
-        for(;;)
-        {
-            work_list_type::iterator work_ptr;
-
-            std::unique_lock lock(m_mutex);
-            bool has_work = m_cond.wait(lock, stoken, [this, id]{ 
-                return work_available_for(id); });
-            
-            if(stoken.stop_requested())
-                break;
-
-            if(!has_work)
-                continue;
-
-            work_ptr = begin_work_for(id);
-            lock.unlock(); // unlock for work to begin;
-
-            (*work_ptr)();
-
-            lock.lock();  // relock to mark work as complete
-            complete_work(work_ptr);
-            lock.unlock();
-            m_cond.notify_one();
-        }
-        std::cerr << "shutting down thread" << std::endl;
-    }
-protected:
-    /**
-     * Worker methods
-     * 
-     * These must be executed under a locked m_mutex;
-     */
-    bool work_available_for(size_t id)
-    { return m_work.size() > id; }
-
-    work_list_type::iterator begin_work_for(size_t id)
-    {  
-        auto e = m_work.begin(),
-             b = e++;
-
-        m_work_began.splice(m_work_began.end(), m_work, b, e);
-        return b;
-    }
-
-    void complete_work(work_list_type::iterator work_ptr)
-    { m_work_began.erase(work_ptr); }
- 
-    void add_work(work_type && work)
-    { m_work.emplace_back(std::move(work)); }
+    scheduler get_scheduler() const
+    { return m_scheduler; }
 
 private:
-    work_list_type m_work;
-    work_list_type m_work_began;
-    
-
-    std::vector<std::jthread *> m_threads;
-    std::stop_source m_stopper;
-    std::mutex m_mutex;
-    std::condition_variable_any m_cond;
+    work_stealing_pool m_pool;
+    scheduler m_scheduler;
 };
 
+// every state of a turn based game from the initial one to the last, the
+// game advances only when the consumer asks for the next state
 template<typename State>
-task<State> turn_based(GameInterface<State> * game)
+async_generator<State const&> turn_based_states(GameInterface<State> * game)
 {
     auto players = co_await game->players();
     auto player_ring = make_ring(players);
@@ -252,6 +196,7 @@ task<State> turn_based(GameInterface<State> * game)
     {
         // send the board out to the player interface
         co_await game->display(state);
+        co_yield state;
 
         // what actions are available to the player?
         auto actions = state.actions();
@@ -260,10 +205,42 @@ task<State> turn_based(GameInterface<State> * game)
         // update the board with the action
         if(!state(selected))
             throw game_error("action rejected by state");
-        // yield the state after this move
     }
 
     co_await game->display(state);
+    co_yield state;
+}
+
+// every state reachable from root, root included, depth first.  lazy, so
+// it can be filtered and cut short with std::views
+template<typename State>
+generator<State const&> game_tree(State root)
+{
+    std::vector<State> stack{std::move(root)};
+    while(!stack.empty())
+    {
+        State state = std::move(stack.back());
+        stack.pop_back();
+
+        auto actions = game_traits<State>::actions(state);
+        for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+        {
+            stack.push_back(state);
+            stack.back()(*a);
+        }
+
+        co_yield state;
+    }
+}
+
+template<typename State>
+task<State> turn_based(GameInterface<State> * game)
+{
+    auto states = turn_based_states(game);
+
+    State state{};
+    while(auto next = co_await states.next())
+        state = std::move(*next);
 
     co_return state;
 }
@@ -0,0 +1,303 @@
+#ifndef __GAME_SERVER_HPP__
+#define __GAME_SERVER_HPP__
+
+#include "game.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+// ends a game whose remote player was cancelled, see game_server::stop
+struct game_cancelled : game_error
+{
+    using game_error::game_error;
+};
+
+/**
+ * A player whose actions arrive from outside the server, from a socket or
+ * a load generator.
+ *
+ * select() parks the game until submit() hands in an action.  submit may
+ * be called from any thread, before or after the game asks, and the game
+ * is resumed on the server's pool rather than on the submitting thread.
+ * turn() is called once the game is waiting, override it to tell the
+ * client it is up.
+ *
+ * cancel() wakes a parked game with game_cancelled, as does every later
+ * select(); actions submitted after it are dropped.
+ */
+template<typename State>
+class remote_player : public PlayerInterface<State>
+{
+public:
+    using action_type = PlayerInterface<State>::action_type;
+
+    explicit remote_player(scheduler sched) :
+        m_slot{sched}
+    { }
+
+    virtual task<action_type>
+    select(Ranges<action_type> const& actions) override
+    {
+        turn(actions);
+        co_return co_await m_slot;
+    }
+
+    // hands in the next action, at most one may be outstanding
+    void submit(action_type action)
+    { m_slot.send(action); }
+
+    void cancel()
+    { m_slot.cancel(); }
+
+protected:
+    virtual void turn(Ranges<action_type> const&)
+    { }
+
+private:
+    // a one slot mailbox, send and the awaiting game race under m_mutex
+    struct action_slot : pool_work
+    {
+        explicit action_slot(scheduler sched) :
+            pool_work{&action_slot::run}, m_scheduler{sched}
+        { }
+
+        bool await_ready() const noexcept
+        { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::lock_guard lock(m_mutex);
+            if(m_value || m_cancelled)
+                return false;
+
+            m_waiting = handle;
+            return true;
+        }
+
+        action_type await_resume()
+        {
+            std::lock_guard lock(m_mutex);
+            if(m_cancelled)
+                throw game_cancelled("remote player cancelled");
+
+            action_type value = *m_value;
+            m_value.reset();
+            return value;
+        }
+
+        void send(action_type value)
+        {
+            // decided under the lock, m_resume is the worker's once posted
+            std::coroutine_handle<> resume;
+            {
+                std::lock_guard lock(m_mutex);
+                if(m_cancelled)
+                    return;
+                if(m_value)
+                    throw game_error("an action is already pending");
+
+                m_value = value;
+                resume = std::exchange(m_waiting, nullptr);
+                if(resume)
+                    m_resume = resume;
+            }
+
+            if(resume)
+                m_scheduler.pool().post(*this);
+        }
+
+        void cancel()
+        {
+            std::coroutine_handle<> resume;
+            {
+                std::lock_guard lock(m_mutex);
+                m_cancelled = true;
+                resume = std::exchange(m_waiting, nullptr);
+                if(resume)
+                    m_resume = resume;
+            }
+
+            if(resume)
+                m_scheduler.pool().post(*this);
+        }
+
+        static void run(pool_work * work)
+        {
+            auto * self = static_cast<action_slot*>(work);
+            std::exchange(self->m_resume, nullptr).resume();
+        }
+
+        scheduler m_scheduler;
+        std::mutex m_mutex;
+        std::optional<action_type> m_value;
+        std::coroutine_handle<> m_waiting;
+        std::coroutine_handle<> m_resume; // set while posted
+        bool m_cancelled = false;
+    };
+
+    action_slot m_slot;
+};
+
+/**
+ * Game server
+ *
+ * Hosts any number of turn_based games on one work_stealing_pool.  A game
+ * holds no thread while it waits for a player, it is a suspended coroutine
+ * until its player's action arrives and is then resumed on whichever
+ * worker is free, so thousands of games share a handful of threads.
+ *
+ *     game_server server(4);
+ *     server.host(game, [](TicTac const& final) { ... });
+ *     server.wait();
+ *
+ * The game and its players must outlive the hosted game.  done is called
+ * on a pool thread and may host further games.
+ *
+ * stop() cancels the remote players of every hosted game, so games parked
+ * on a client that will never answer end with game_cancelled instead of
+ * holding up the destructor forever.  Cancelled games are not errors and
+ * do not call done.
+ */
+class game_server
+{
+public:
+    explicit game_server(size_t thread_count =
+        std::thread::hardware_concurrency()) :
+        m_pool{thread_count}, m_scheduler{m_pool},
+        m_hosted{}, m_active{0}, m_finished{0}, m_cancelled{0}, m_error{},
+        m_stopping{false}
+    { }
+
+    game_server(game_server const &) = delete;
+    game_server & operator=(game_server const &) = delete;
+
+    // stops and waits for the hosted games before the pool goes away
+    ~game_server()
+    {
+        stop();
+
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this]{ return m_active == 0; });
+    }
+
+    template<typename State, typename Done>
+    void host(GameInterface<State> & game, Done done)
+    {
+        hosted_list::iterator hosted;
+        {
+            std::lock_guard lock(m_mutex);
+            if(m_stopping)
+                throw game_error("game server stopped");
+
+            hosted = m_hosted.insert(m_hosted.end(), [&game]{
+                for(auto * player : game.players_view())
+                    if(auto * remote =
+                        dynamic_cast<remote_player<State>*>(player))
+                        remote->cancel();
+            });
+            ++m_active;
+        }
+        run_game(game, std::move(done), hosted);
+    }
+
+    template<typename State>
+    void host(GameInterface<State> & game)
+    { host(game, [](State const&) { }); }
+
+    // blocks until every hosted game has finished, rethrows the first
+    // error a game ended with
+    void wait()
+    {
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this]{ return m_active == 0; });
+        if(m_error)
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+    size_t active() const
+    {
+        std::lock_guard lock(m_mutex);
+        return m_active;
+    }
+
+    // cancels the remote players of every hosted game and refuses new
+    // games, games waiting on no remote player still run to the end
+    void stop()
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+        for(auto const & cancel : m_hosted)
+            cancel();
+    }
+
+    size_t finished() const
+    { return m_finished.load(std::memory_order_relaxed); }
+
+    size_t cancelled() const
+    { return m_cancelled.load(std::memory_order_relaxed); }
+
+    scheduler get_scheduler() const
+    { return m_scheduler; }
+
+private:
+    // cancels the remote players of one hosted game, the entry is erased
+    // under m_mutex before the game finishes
+    using hosted_list = std::list<std::function<void()>>;
+
+    template<typename State, typename Done>
+    detached_task run_game(GameInterface<State> & game, Done done,
+        hosted_list::iterator hosted)
+    {
+        std::exception_ptr error;
+        bool cancelled = false;
+        try {
+            co_await m_scheduler.schedule();
+            done(co_await turn_based<State>(&game));
+        } catch(game_cancelled const &) {
+            cancelled = true;
+        } catch(...) {
+            error = std::current_exception();
+        }
+        finish(hosted, error, cancelled);
+    }
+
+    void finish(hosted_list::iterator hosted, std::exception_ptr error,
+        bool cancelled)
+    {
+        if(cancelled)
+            m_cancelled.fetch_add(1, std::memory_order_relaxed);
+        else
+            m_finished.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard lock(m_mutex);
+        m_hosted.erase(hosted);
+        if(error && !m_error)
+            m_error = error;
+        if(--m_active == 0)
+            m_idle.notify_all();
+    }
+
+    work_stealing_pool m_pool;
+    scheduler m_scheduler;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_idle;
+    hosted_list m_hosted;             // under m_mutex
+    size_t m_active;                  // under m_mutex
+    std::atomic<size_t> m_finished;
+    std::atomic<size_t> m_cancelled;
+    std::exception_ptr m_error;       // under m_mutex
+    bool m_stopping;                  // under m_mutex
+};
+
+#endif
@@ -1,34 +1,115 @@
 #ifndef __GENERATOR_H__
 #define __GENERATOR_H__
 
+#include "promise_allocator.hpp"
+
 #include <coroutine>
 #include <variant>
 #include <stdexcept>
 #include <optional>
+#include <memory>
+#include <concepts>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+// co_yield elements_of(range) yields every element of range in turn.  a
+// nested generator of the same type yields straight to the consumer of
+// the outermost one, so a recursion d levels deep still costs a single
+// resume per element
+template<typename R>
+struct elements_of
+{
+    R range;
+};
 
+template<typename R>
+elements_of(R&&) -> elements_of<R&&>;
+
+// generator<T> hands out a moved copy of every yielded value,
+// generator<T&> and generator<T const&> a reference to the object the
+// producer yielded, which stays valid until the generator is resumed
+//
+// a generator is a std::ranges::view over an input range, so it composes
+// with views::filter, views::take and friends without materializing
+// anything
 template<typename T>
-class generator {
+class generator : public std::ranges::view_base {
 public:
-    class promise_type {
+    // a pointer to the yielded object in reference mode
+    using stored_type = std::conditional_t<std::is_reference_v<T>,
+        std::add_pointer_t<T>, T>;
+
+    class promise_type : public allocator_aware_promise<> {
     public:
         promise_type() noexcept;
         ~promise_type();
 
+        // a nested generator hands control back to the one that yielded
+        // it, the outermost one to its consumer
+        struct final_awaiter {
+            bool await_ready() noexcept;
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() noexcept;
+        };
+
+        // runs a nested generator until it finishes, its elements go to
+        // the outermost consumer.  Holder owns the nested generator or
+        // refers to it
+        template<typename Holder>
+        struct nested_awaiter {
+            bool await_ready() noexcept;
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume();
+
+            Holder child_;
+        };
+
         generator get_return_object() noexcept;
         std::suspend_always initial_suspend() noexcept;
-        std::suspend_always final_suspend() noexcept;
+        final_awaiter final_suspend() noexcept;
         void unhandled_exception() noexcept;
         void return_void() noexcept;
 
         template<std::convertible_to<T> From>
+            requires (!std::is_reference_v<T>)
         std::suspend_always yield_value(From&&) noexcept;
 
+        // a temporary converted for the reference lives in the producer's
+        // co_yield expression, until the producer is resumed
+        std::suspend_always yield_value(T) noexcept
+            requires std::is_reference_v<T>;
+
+        template<typename R>
+            requires std::same_as<std::remove_cvref_t<R>, generator>
+        auto yield_value(elements_of<R> nested) noexcept;
+
+        // any other range is walked by a nested generator
+        template<std::ranges::input_range R>
+            requires (!std::same_as<std::remove_cvref_t<R>, generator>)
+        auto yield_value(elements_of<R> nested);
+
     private:
         friend generator;
 
-        std::variant<std::monostate, T, std::exception_ptr> result_;
+        template<typename View>
+        static generator walk(View view);
+
+        // yielded values and the current position live in the outermost
+        // generator's promise, root_ points there
+        promise_type * root_;
+        std::coroutine_handle<promise_type> parent_;
+        std::coroutine_handle<promise_type> active_; // root only
+
+        // monostate once the current value has been consumed, a nested
+        // generator only keeps its exception here
+        std::variant<std::monostate, stored_type, std::exception_ptr> result_;
     };
 
+    using handle_type = std::coroutine_handle<promise_type>;
+
     bool done();
     T next();
 
@@ -37,40 +118,48 @@ public:
     T operator()();  // last yielded value and resume
 
     // publicly move constructable 
+    generator() noexcept;
     generator(generator&& g) noexcept;
     generator& operator=(generator&& g) noexcept;
     ~generator();
 
-    // to handle range iteration
-    struct iterator
+    // an input iterator, the producer is resumed by operator++ only so
+    // dereferencing any number of times sees the same value
+    class iterator
     {
-        T operator*() const;
-        // no operator-> since calling one would also resume the coroutine
-        // and invalidate any further pointer access
+    public:
+        using value_type = std::remove_cvref_t<T>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<std::is_reference_v<T>, 
+            T, T&>;
+
+        iterator() noexcept;
+
+        reference operator*() const;
         iterator& operator++();
-        iterator& operator=(iterator const&);
+        void operator++(int);
 
-        bool operator==(std::default_sentinel_t) const;
-        bool operator!=(std::default_sentinel_t) const;
+        bool operator==(std::default_sentinel_t) const noexcept;
 
-        generator<T>* gen_;
+    private:
+        friend generator;
+        explicit iterator(handle_type) noexcept;
 
-        explicit iterator(generator<T>*);
+        handle_type coro_;
     };
 
     iterator begin();
-    std::default_sentinel_t end();
+    std::default_sentinel_t end() const noexcept;
 
 private:
     // privately constructable by friend promise_type in get_return_object
-    explicit generator(std::coroutine_handle<promise_type>) noexcept;
+    explicit generator(handle_type) noexcept;
 
-    // potentially idempotent method to resume coroutine if we have consumed
-    // a value
-    void fill();
+    // resumes the producer unless it holds a value nobody has consumed
+    // yet, rethrows whatever the producer threw
+    static void fill(handle_type);
 
-    std::coroutine_handle<promise_type> coro_;
-    bool full_;
+    handle_type coro_;
 };
 
 /***
@@ -78,8 +167,10 @@ private:
  */
 template<typename T>
 generator<T> generator<T>::promise_type::get_return_object() noexcept
-{ return generator<T>{
-    std::coroutine_handle<promise_type>::from_promise(*this)}; }
+{ 
+    active_ = std::coroutine_handle<promise_type>::from_promise(*this);
+    return generator<T>{active_}; 
+}
 
 template<typename T>
 std::suspend_always generator<T>::promise_type::initial_suspend() noexcept
@@ -95,21 +186,59 @@ void generator<T>::promise_type::return_void() noexcept
 
 template<typename T>
 template<std::convertible_to<T> From>
+    requires (!std::is_reference_v<T>)
 std::suspend_always
 generator<T>::promise_type::yield_value(From&& from) noexcept
 { 
-    result_ = std::forward<From>(from);
+    root_->result_.template emplace<1>(std::forward<From>(from));
     return {};
 }
 
 template<typename T>
 std::suspend_always
+generator<T>::promise_type::yield_value(T value) noexcept
+    requires std::is_reference_v<T>
+{ 
+    root_->result_ = std::addressof(value);
+    return {};
+}
+
+template<typename T>
+template<typename R>
+    requires std::same_as<std::remove_cvref_t<R>, generator<T>>
+auto generator<T>::promise_type::yield_value(elements_of<R> nested) noexcept
+{
+    // an rvalue generator is owned by the awaiter, in this frame
+    using holder = std::conditional_t<std::is_lvalue_reference_v<R>, 
+        generator<T>&, generator<T>>;
+    return nested_awaiter<holder>{std::forward<R>(nested.range)};
+}
+
+template<typename T>
+template<std::ranges::input_range R>
+    requires (!std::same_as<std::remove_cvref_t<R>, generator<T>>)
+auto generator<T>::promise_type::yield_value(elements_of<R> nested)
+{ 
+    return nested_awaiter<generator<T>>{
+        walk(std::views::all(std::forward<R>(nested.range)))}; 
+}
+
+template<typename T>
+template<typename View>
+generator<T> generator<T>::promise_type::walk(View view)
+{
+    for(auto&& element : view)
+        co_yield static_cast<T>(element);
+}
+
+template<typename T>
+generator<T>::promise_type::final_awaiter
 generator<T>::promise_type::final_suspend() noexcept
 { return {}; }
 
 template<typename T>
 generator<T>::promise_type::promise_type() noexcept :
-    result_{}
+    root_{this}, parent_{}, active_{}, result_{}
 { 
     // std::cerr << "\ngenerator<T>::promise_type[" << std::hex << this << std::dec << "]" << std::endl;
 }
@@ -120,20 +249,82 @@ generator<T>::promise_type::~promise_type()
     // std::cerr << "\ngenerator<T>::~promise_type[" << std::hex << this << std::dec << "]" << std::endl;
 }
 
+/***
+ * promise_type::final_awaiter
+ */
+template<typename T>
+bool generator<T>::promise_type::final_awaiter::await_ready() noexcept
+{ return false; }
+
+template<typename T>
+std::coroutine_handle<> 
+generator<T>::promise_type::final_awaiter::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept
+{
+    auto& p = h.promise();
+    if(!p.parent_)
+        return std::noop_coroutine();
+
+    p.root_->active_ = p.parent_;
+    return p.parent_;
+}
+
+template<typename T>
+void generator<T>::promise_type::final_awaiter::await_resume() noexcept
+{ }
+
+/***
+ * promise_type::nested_awaiter
+ */
+template<typename T>
+template<typename Holder>
+bool generator<T>::promise_type::nested_awaiter<Holder>::await_ready() 
+    noexcept
+{ return !child_.coro_ || child_.coro_.done(); }
+
+template<typename T>
+template<typename Holder>
+std::coroutine_handle<> 
+generator<T>::promise_type::nested_awaiter<Holder>::await_suspend(
+    std::coroutine_handle<promise_type> h) noexcept
+{
+    auto& root = *h.promise().root_;
+    auto& child = child_.coro_.promise();
+
+    child.root_ = &root;
+    child.parent_ = h;
+    root.active_ = child_.coro_;
+    return child_.coro_;
+}
+
+template<typename T>
+template<typename Holder>
+void generator<T>::promise_type::nested_awaiter<Holder>::await_resume()
+{
+    if(!child_.coro_)
+        return;
+
+    auto& child = child_.coro_.promise();
+    if(child.result_.index() == 2)
+        std::rethrow_exception(std::get<2>(child.result_));
+}
+
 /***
  * generator
  */
+template<typename T>
+generator<T>::generator() noexcept :
+    coro_{}
+{ }
+
 template<typename T>
 generator<T>::generator(generator<T>&& g) noexcept :
-    coro_{g.coro_}, full_{g.full_}
-{ 
-    g.coro_ = nullptr;
-    g.full_ = false;
-}
+    coro_{std::exchange(g.coro_, nullptr)}
+{ }
 
 template<typename T>
-generator<T>::generator(std::coroutine_handle<promise_type> h) noexcept :
-    coro_{h}, full_{false}
+generator<T>::generator(handle_type h) noexcept :
+    coro_{h}
 { }
 
 template<typename T>
@@ -141,17 +332,19 @@ generator<T>& generator<T>::operator=(generator<T>&& g) noexcept
 {
     if(this == &g)
         return *this;
-    coro_ = g.coro_;
-    full_ = g.full_;
-    g.coro_ = nullptr;
-    g.full_ = false;
+    if(coro_)
+        coro_.destroy();
+    coro_ = std::exchange(g.coro_, nullptr);
     return *this;
 }
 
 template<typename T>
 bool generator<T>::done()
 { 
-    fill();
+    if(!coro_)
+        return true;
+
+    fill(coro_);
     return coro_.done();
 }
 
@@ -162,15 +355,17 @@ generator<T>::operator bool()
 template<typename T>
 T generator<T>::next()
 {
-    using std::holds_alternative, std::exception_ptr, std::rethrow_exception;
-    fill();
+    if(done())
+        throw std::logic_error("generator is done");
 
     auto& p = coro_.promise();
-    if(holds_alternative<exception_ptr>(p.result_))
-        rethrow_exception(std::get<exception_ptr>(p.result_));
+    stored_type value = std::move(std::get<1>(p.result_));
+    p.result_.template emplace<0>();
 
-    full_ = false;
-    return std::move(std::get<T>(p.result_));
+    if constexpr(std::is_reference_v<T>)
+        return static_cast<T>(*value);
+    else
+        return value;
 }
 
 template<typename T>
@@ -178,61 +373,79 @@ T generator<T>::operator()()
 { return next(); }
 
 template<typename T>
-void generator<T>::fill()
+void generator<T>::fill(handle_type coro)
 {
-    if(full_)
+    auto& p = coro.promise();
+    if(p.result_.index() == 1 || coro.done())
         return;
 
-    coro_.resume();
-    full_ = true;
+    // the innermost nested generator, the root itself without nesting
+    p.active_.resume();
+
+    if(p.result_.index() == 2)
+    {
+        auto e = std::get<2>(p.result_);
+        p.result_.template emplace<0>();
+        std::rethrow_exception(e);
+    }
 }
 
 template<typename T>
 generator<T>::iterator generator<T>::begin()
-{ return iterator{this}; }
+{
+    if(coro_)
+        fill(coro_);
+    return iterator{coro_};
+}
 
 template<typename T>
-std::default_sentinel_t generator<T>::end()
+std::default_sentinel_t generator<T>::end() const noexcept
 { return std::default_sentinel; }
 
 template<typename T>
 generator<T>::~generator() 
-{ coro_.destroy(); }
+{ 
+    if(coro_)
+        coro_.destroy(); 
+}
 
 /*** 
  * iterator
  */
 template<typename T>
-generator<T>::iterator::iterator(generator<T>* gen) : 
-    gen_{gen}
+generator<T>::iterator::iterator() noexcept :
+    coro_{}
 { }
 
 template<typename T>
-T generator<T>::iterator::operator*() const
-{ return (*gen_)(); }
-
+generator<T>::iterator::iterator(handle_type coro) noexcept :
+    coro_{coro}
+{ }
 
 template<typename T>
-generator<T>::iterator& generator<T>::iterator::operator++()
-{ return *this; }
+generator<T>::iterator::reference generator<T>::iterator::operator*() const
+{ 
+    if constexpr(std::is_reference_v<T>)
+        return static_cast<T>(*std::get<1>(coro_.promise().result_));
+    else
+        return std::get<1>(coro_.promise().result_);
+}
 
 template<typename T>
-generator<T>::iterator& 
-generator<T>::iterator::operator=(generator<T>::iterator const& other)
-{
-    if(this == &other)
-        return *this;
-    gen_ = other.gen_;
-    return *this;
+generator<T>::iterator& generator<T>::iterator::operator++()
+{ 
+    coro_.promise().result_.template emplace<0>();
+    fill(coro_);
+    return *this; 
 }
 
 template<typename T>
-bool generator<T>::iterator::operator==(std::default_sentinel_t) const
-{ return gen_ == nullptr || !*gen_; } // 
+void generator<T>::iterator::operator++(int)
+{ ++*this; }
 
 template<typename T>
-bool generator<T>::iterator::operator!=(std::default_sentinel_t) const
-{ return gen_ != nullptr && *gen_; }
+bool generator<T>::iterator::operator==(std::default_sentinel_t) const noexcept
+{ return !coro_ || coro_.done(); }
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,375 @@
+#ifndef __INCREMENTAL_CHECKPOINT_HPP__
+#define __INCREMENTAL_CHECKPOINT_HPP__
+
+#include "saveable_coroutine.hpp"
+#include "checksum.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Incremental checkpoints
+ *
+ * A checkpoint series starts with a full snapshot (saveable_base::save)
+ * followed by any number of delta records, each relative to the chain as
+ * it was at the previous checkpoint:
+ *
+ *     | delta_header | delta_frame | delta_range | bytes | ... | ...
+ *
+ * Every frame of the chain gets a delta_frame naming the frame of the
+ * previous checkpoint it continues and the byte ranges of its data that 
+ * changed since then, so an unchanged frame costs 16 bytes.  A new frame 
+ * (source == new_frame) is followed by its frame_header and carries all of
+ * its data in one range.
+ *
+ * checksum is the crc32c of the whole record with a zero checksum.
+ */
+static constexpr inline std::uint64_t checkpoint_delta_magic =
+    0x31'41'54'4c'45'44'43'53; // "SCDELTA1"
+
+struct delta_header
+{
+    std::uint64_t magic;
+    version_t version;
+    std::uint64_t frame_count;
+    std::uint64_t size; // of the whole record including this header
+    std::uint64_t checksum;
+};
+
+struct delta_frame
+{
+    static constexpr std::uint64_t new_frame = ~std::uint64_t(0);
+
+    std::uint64_t source;    // index in the previous checkpoint
+    std::uint64_t range_count;
+};
+
+struct delta_range
+{
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+// remembers the image of every frame of one coroutine chain as of its last
+// checkpoint and writes only what changed since
+//
+// frames are matched by address and hash code, changes are found by
+// comparing BlockSize byte blocks.
+template<size_t BlockSize = 64>
+class incremental_checkpoint
+{
+public:
+    // writes a full snapshot and remembers it as the base for deltas
+    void save_base(saveable_base const & coroutine, std::ostream & os)
+    {
+        coroutine.save(os);
+        remember(coroutine);
+    }
+
+    // writes the changes since the last checkpoint, returns the size of the
+    // delta record
+    size_t save_delta(saveable_base const & coroutine, std::ostream & os)
+    {
+        if(!m_based)
+            throw std::logic_error("incremental checkpoint without a base");
+
+        thread_local std::vector<char> s_record;
+        s_record.resize(sizeof(delta_header));
+
+        delta_header header = {
+            .magic = checkpoint_delta_magic,
+            .version = saveable_coroutine_version,
+            .frame_count = coroutine.frame_count(),
+            .size = 0,
+            .checksum = 0,
+        };
+
+        std::vector<frame_image> images;
+        images.reserve(header.frame_count);
+
+        coroutine.for_each_frame([&](frame_header const & wh,
+            char const * data)
+        {
+            void * address = const_cast<char*>(data);
+            std::uint64_t source = find(address, wh, images.size());
+
+            images.push_back({address, wh.hash_code, {}});
+            frame_image & image = images.back();
+
+            size_t at = s_record.size();
+            append(s_record, delta_frame{source, 0});
+
+            std::uint64_t range_count = 0;
+            if(source == delta_frame::new_frame)
+            {
+                append(s_record, wh);
+                image.m_data.assign(data, data + wh.data_size);
+                append_range(s_record, data, 0, wh.data_size);
+                range_count = 1;
+            }
+            else
+            {
+                image.m_data = std::move(m_frames[source].m_data);
+                range_count = diff(s_record, image.m_data, data);
+            }
+
+            reinterpret_cast<delta_frame*>(s_record.data() + at)->range_count
+                = range_count;
+        });
+
+        header.size = s_record.size();
+        std::memcpy(s_record.data(), &header, sizeof(header));
+        header.checksum = crc32c::compute(s_record.data(), s_record.size());
+        std::memcpy(s_record.data(), &header, sizeof(header));
+        os.write(s_record.data(), s_record.size());
+
+        m_frames = std::move(images);
+        return header.size;
+    }
+
+    // the next checkpoint has to be a base again
+    void reset()
+    {
+        m_frames.clear();
+        m_based = false;
+    }
+
+private:
+    struct frame_image
+    {
+        void * m_address;
+        size_t m_hash_code;
+        std::vector<char> m_data;
+    };
+
+    void remember(saveable_base const & coroutine)
+    {
+        m_frames.clear();
+        coroutine.for_each_frame([this](frame_header const & wh,
+            char const * data)
+        {
+            m_frames.push_back({const_cast<char*>(data), wh.hash_code,
+                std::vector<char>(data, data + wh.data_size)});
+        });
+        m_based = true;
+    }
+
+    bool matches(size_t i, void * address, frame_header const & wh) const
+    {
+        return m_frames[i].m_address == address &&
+               m_frames[i].m_hash_code == wh.hash_code &&
+               m_frames[i].m_data.size() == wh.data_size;
+    }
+
+    // frames usually keep their position in the chain, so try that first
+    std::uint64_t find(void * address, frame_header const & wh, 
+        size_t position) const
+    {
+        if(position < m_frames.size() && matches(position, address, wh))
+            return position;
+
+        for(size_t i = 0; i < m_frames.size(); ++i)
+            if(matches(i, address, wh))
+                return i;
+        return delta_frame::new_frame;
+    }
+
+    template<typename T>
+    static void append(std::vector<char> & record, T const & value)
+    {
+        size_t at = record.size();
+        record.resize(at + sizeof(T));
+        std::memcpy(record.data() + at, &value, sizeof(T));
+    }
+
+    static void append_range(std::vector<char> & record, char const * data,
+        size_t offset, size_t length)
+    {
+        append(record, delta_range{offset, length});
+        record.insert(record.end(), data + offset, data + offset + length);
+    }
+
+    // appends the ranges of data that differ from image and brings image
+    // up to date, returns the number of ranges
+    static std::uint64_t diff(std::vector<char> & record,
+        std::vector<char> & image, char const * data)
+    {
+        std::uint64_t range_count = 0;
+        size_t size = image.size();
+
+        for(size_t b = 0; b < size; )
+        {
+            size_t len = std::min(BlockSize, size - b);
+            if(std::memcmp(image.data() + b, data + b, len) == 0)
+            {
+                b += len;
+                continue;
+            }
+
+            // merge neighbouring dirty blocks into one range
+            size_t e = b + len;
+            while(e < size)
+            {
+                size_t next = std::min(BlockSize, size - e);
+                if(std::memcmp(image.data() + e, data + e, next) == 0)
+                    break;
+                e += next;
+            }
+
+            append_range(record, data, b, e - b);
+            std::memcpy(image.data() + b, data + b, e - b);
+            ++range_count;
+            b = e;
+        }
+
+        return range_count;
+    }
+
+    std::vector<frame_image> m_frames;
+    bool m_based = false;
+};
+
+// applies one delta record read from is to a full snapshot, returns false
+// if is holds no further record
+inline bool apply_checkpoint_delta(std::vector<char> & snapshot,
+    std::istream & is)
+{
+    delta_header header;
+    std::uint32_t checksum = 0;
+    std::uint64_t left = 0; // of the size the header declares
+
+    // reads from the record, keeping track of its checksum and never past
+    // its declared end
+    auto read = [&is, &checksum, &left](void * to, size_t size) {
+        if(size > left)
+            throw std::logic_error("corrupt checkpoint delta");
+        if(!is.read(reinterpret_cast<char*>(to), size))
+            throw std::logic_error("truncated checkpoint delta");
+        checksum = crc32c::update(checksum, to, size);
+        left -= size;
+    };
+
+    if(!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        if(is.gcount() == 0)
+            return false;
+        throw std::logic_error("truncated checkpoint delta");
+    }
+
+    if(header.magic != checkpoint_delta_magic)
+        throw std::logic_error("not a checkpoint delta");
+
+    if(header.version != saveable_coroutine_version)
+        throw std::logic_error("version mismatch");
+
+    if(header.frame_count > max_snapshot_frames ||
+       header.size < sizeof(header))
+        throw std::logic_error("corrupt checkpoint delta");
+    left = header.size - sizeof(header);
+
+    {
+        delta_header h = header;
+        h.checksum = 0;
+        checksum = crc32c::compute(&h, sizeof(h));
+    }
+
+    // locate the frames of the previous checkpoint, checking them on the
+    // way
+    size_t frame_count = validate_snapshot(snapshot);
+
+    std::vector<size_t> previous;
+    size_t offset = 0;
+    for(size_t f = 0; f < frame_count; ++f)
+    {
+        frame_header fh;
+        std::memcpy(&fh, snapshot.data() + offset, sizeof(fh));
+
+        if(fh.flags & frame_compressed)
+            throw std::logic_error("checkpoint base must not be compressed");
+
+        previous.push_back(offset);
+        offset += sizeof(fh) + padded_frame_size(fh.data_size);
+    }
+
+    if(offset != snapshot.size())
+        throw std::logic_error("trailing bytes after checkpoint base");
+
+    std::vector<char> result;
+    std::uint32_t chained = 0;
+    for(std::uint64_t f = 0; f < header.frame_count; ++f)
+    {
+        delta_frame df;
+        read(&df, sizeof(df));
+
+        frame_header fh;
+        if(df.source == delta_frame::new_frame)
+        {
+            read(&fh, sizeof(fh));
+            if(fh.data_size > max_frame_data_size)
+                throw std::logic_error("corrupt checkpoint delta");
+        }
+        else if(df.source < previous.size())
+        {
+            std::memcpy(&fh, snapshot.data() + previous[df.source], 
+                sizeof(fh));
+        }
+        else
+            throw std::logic_error("checkpoint delta does not match its base");
+
+        fh.frame_count = header.frame_count - f;
+        fh.flags = 0;
+
+        size_t at = result.size();
+        size_t data_size = fh.data_size;
+        result.resize(at + sizeof(frame_header) + padded_frame_size(data_size));
+
+        char * data = result.data() + at + sizeof(frame_header);
+        if(df.source != delta_frame::new_frame)
+            std::memcpy(data, snapshot.data() + previous[df.source] 
+                + sizeof(frame_header), data_size);
+
+        for(std::uint64_t r = 0; r < df.range_count; ++r)
+        {
+            delta_range range;
+            read(&range, sizeof(range));
+            if(range.offset > data_size ||
+               range.length > data_size - range.offset)
+                throw std::logic_error("corrupt checkpoint delta");
+            read(data + range.offset, range.length);
+        }
+
+        // the frames are checksummed again as part of the new snapshot
+        fh.checksum = chained = frame_checksum(fh, data, chained);
+        std::memcpy(result.data() + at, &fh, sizeof(frame_header));
+    }
+
+    // the frames have to use up the record exactly
+    if(left != 0)
+        throw std::logic_error("corrupt checkpoint delta");
+
+    if(checksum != header.checksum)
+        throw std::logic_error("checksum mismatch");
+
+    snapshot = std::move(result);
+    return true;
+}
+
+// restores a coroutine from a base snapshot followed by every delta record
+// left in deltas
+template<typename HandleType, typename... ArgTypes>
+saveable<HandleType> load_coro_incremental(std::istream & base,
+    std::istream & deltas, ArgTypes &... args)
+{
+    std::vector<char> snapshot = read_snapshot(base);
+
+    while(apply_checkpoint_delta(snapshot, deltas))
+        ;
+
+    return load_coro<HandleType>(std::span<char const>{snapshot}, args...);
+}
+
+#endif
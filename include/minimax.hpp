@@ -57,6 +57,8 @@ public:
         // HACK: 0 means no score has been found
         int best_score = 0;
 
+        m_nodes = 0;
+
         while(!stack.empty())
         {
             // pop the next one off the stack
@@ -99,6 +101,7 @@ public:
             
             // make the move
             state(*cur);
+            ++m_nodes;
 
             // do we know how much this one is worth?
             auto i = m_scores.find(state);
@@ -137,6 +140,10 @@ public:
         co_return best_action;
     }
 
+    // states visited by the last select
+    size_t nodes() const
+    { return m_nodes; }
+
     // DEBUG
     void dump() 
     {
@@ -150,6 +157,7 @@ public:
 private:
     State m_current;
     std::map<State, int> m_scores; // always for the current player
+    size_t m_nodes = 0;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,263 @@
+#ifndef __PARALLEL_SEARCH_HPP__
+#define __PARALLEL_SEARCH_HPP__
+
+#include "game.hpp"
+#include "alpha_beta.hpp"
+#include "scheduler.hpp"
+#include "when_all.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+/**
+ * Parallel alpha-beta search
+ *
+ * Splits the moves at the root over the threads of a scheduler's pool.
+ * The first move is searched alone with the full window (young brothers
+ * wait), the rest are handed out one at a time to a worker per thread,
+ * each with its own alpha_beta_search.  They share one transposition
+ * table, which needs no locks, and the best score found so far so a later
+ * move is searched with the tightest window known.
+ *
+ * The result does not depend on the number of threads or on timing: of
+ * the moves scoring best the one the game listed first is played.  A move
+ * is searched with alpha at the best exact score so far of the moves
+ * listed before it, as a tie with those goes to them, and one below that
+ * of the moves listed after it.  Alpha is then never as high as the score
+ * of the move that is played, which comes back exact, and any other move
+ * comes back lower or tied but listed later.
+ *
+ *     parallel_alpha_beta_search<TicTac4> search(sched, 4);
+ *     auto r = co_await search.search(state, state.actions());
+ *
+ * The awaiting coroutine resumes on whichever pool thread finished last.
+ */
+template<typename State>
+class parallel_alpha_beta_search
+{
+public:
+    using search_type = alpha_beta_search<State>;
+    using action_type = search_type::action_type;
+    using table_type = search_type::table_type;
+    using result = search_type::result;
+
+    static constexpr int infinity = search_type::infinity;
+
+    parallel_alpha_beta_search(scheduler sched, size_t thread_count,
+        size_t table_bytes = search_type::default_table_bytes) :
+        m_scheduler{sched},
+        m_table{table_bytes > 0 ? std::make_shared<table_type>(table_bytes)
+                                : nullptr},
+        m_searches{}
+    {
+        m_searches.reserve(std::max<size_t>(1, thread_count));
+        for(size_t i = 0; i < std::max<size_t>(1, thread_count); ++i)
+            m_searches.emplace_back(m_table);
+    }
+
+    // searches to the end of the game, from root limited to actions
+    task<result> search(State root, Ranges<action_type> actions)
+    {
+        if(actions.size() == 0)
+            throw game_error("no actions to search");
+        if(m_table)
+            m_table->new_search();
+
+        std::vector<action_type> moves;
+        for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+            moves.push_back(*a);
+
+        std::vector<size_t> order = guess_order(root, moves);
+        std::vector<int> scores(moves.size(), -infinity);
+
+        // the first move alone, it sets the window for the others
+        size_t first = order[0];
+        auto r = m_searches[0].search(root, only(moves[first]));
+        scores[first] = r.m_score;
+        size_t nodes = r.m_nodes;
+
+        std::vector<std::atomic<int>> exact(moves.size());
+        for(auto & e : exact)
+            e.store(-infinity, std::memory_order_relaxed);
+        exact[first].store(r.m_score, std::memory_order_relaxed);
+        std::atomic<size_t> next{1};
+
+        std::vector<task<size_t>> workers;
+        for(size_t w = 0; w < m_searches.size() && w + 1 < moves.size(); ++w)
+            workers.push_back(split(m_searches[w], root, moves, order,
+                scores, exact, next));
+        if(!workers.empty())
+            for(size_t n : co_await when_all(m_scheduler, std::move(workers)))
+                nodes += n;
+
+        // ties go to the move listed first, whoever searched it
+        size_t best = 0;
+        for(size_t i = 1; i < moves.size(); ++i)
+            if(scores[i] > scores[best])
+                best = i;
+
+        co_return result{moves[best], scores[best], nodes};
+    }
+
+    task<result> search(State root)
+    {
+        auto actions = game_traits<State>::actions(root);
+        co_return co_await search(std::move(root), std::move(actions));
+    }
+
+    // forgets what every thread learned, never while searching
+    void clear()
+    {
+        for(auto & s : m_searches)
+            s.clear();
+    }
+
+    size_t thread_count() const
+    { return m_searches.size(); }
+
+    // nullptr when searching without one
+    table_type const* table() const
+    { return m_table.get(); }
+
+    // use of the table by every thread
+    table_type::statistics stats() const
+    {
+        typename table_type::statistics total{};
+        for(auto const& s : m_searches)
+        {
+            total.m_probes += s.stats().m_probes;
+            total.m_hits += s.stats().m_hits;
+            total.m_stores += s.stats().m_stores;
+        }
+        return total;
+    }
+
+private:
+    // searches moves[order[next]] until none are left, yields the nodes
+    static task<size_t> split(search_type & search, State const& root,
+        std::vector<action_type> const& moves,
+        std::vector<size_t> const& order, std::vector<int> & scores,
+        std::vector<std::atomic<int>> & exact, std::atomic<size_t> & next)
+    {
+        size_t nodes = 0;
+        for(size_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) <
+            moves.size(); )
+        {
+            size_t i = order[k];
+            int alpha = window(exact, i);
+
+            // a null window first, most moves are no better
+            auto r = search.search(root, only(moves[i]), alpha, alpha + 1);
+            nodes += r.m_nodes;
+            if(r.m_score > alpha)
+            {
+                r = search.search(root, only(moves[i]), alpha, infinity);
+                nodes += r.m_nodes;
+            }
+
+            scores[i] = r.m_score;
+            if(r.m_score > alpha)
+                exact[i].store(r.m_score, std::memory_order_relaxed);
+        }
+        co_return nodes;
+    }
+
+    // the alpha to search move i with, from the exact scores known so far.
+    // a move listed before i wins a tie so i only has to be shown no
+    // better, a move listed after it does not so i has to be shown worse
+    static int window(std::vector<std::atomic<int>> const& exact, size_t i)
+    {
+        int alpha = -infinity;
+        for(size_t j = 0; j < exact.size(); ++j)
+        {
+            int score = exact[j].load(std::memory_order_relaxed);
+            if(score > -infinity)
+                alpha = std::max(alpha, j < i ? score : score - 1);
+        }
+        return alpha;
+    }
+
+    // moves the table scored well first, otherwise in the game's order
+    std::vector<size_t> guess_order(State const& root,
+        std::vector<action_type> const& moves) const
+    {
+        std::vector<size_t> order(moves.size());
+        std::iota(order.begin(), order.end(), 0);
+        if(!m_table)
+            return order;
+
+        std::vector<int> guess(moves.size(), -infinity);
+        for(size_t i = 0; i < moves.size(); ++i)
+        {
+            State child = root;
+            child(moves[i]);
+            if(auto e = m_table->probe(game_traits<State>::hash(child)))
+                guess[i] = -e->m_score;
+        }
+
+        std::stable_sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) { return guess[a] > guess[b]; });
+        return order;
+    }
+
+    static Ranges<action_type> only(action_type action)
+    {
+        Ranges<action_type> ret;
+        action_type end = action;
+        ret.insert(action, ++end);
+        return ret;
+    }
+
+    scheduler m_scheduler;
+    std::shared_ptr<table_type> m_table;
+    std::vector<search_type> m_searches; // one per thread
+};
+
+// plays the best move parallel_alpha_beta_search finds on the threads of
+// sched, a ThreadedGame's for instance
+template<typename State>
+class ParallelAlphaBetaInterface : public PlayerInterface<State> {
+public:
+    using action_type = game_traits<State>::action_type;
+    using search_type = parallel_alpha_beta_search<State>;
+
+    explicit ParallelAlphaBetaInterface(scheduler sched) :
+        ParallelAlphaBetaInterface{sched, sched.pool().size()}
+    { }
+
+    ParallelAlphaBetaInterface(scheduler sched, size_t thread_count,
+        size_t table_bytes = search_type::search_type::default_table_bytes) :
+        m_current{}, m_search{sched, thread_count, table_bytes}
+    { }
+
+    virtual task<void> display(State const& state) override
+    {
+        m_current = state;
+        co_return;
+    }
+
+    virtual task<action_type>
+    select(Ranges<action_type> const& actions) override
+    {
+        auto result = co_await m_search.search(m_current, actions);
+        m_nodes = result.m_nodes;
+        co_return result.m_action;
+    }
+
+    // nodes visited by the last select
+    size_t nodes() const
+    { return m_nodes; }
+
+    search_type const& search() const
+    { return m_search; }
+
+private:
+    State m_current;
+    search_type m_search;
+    size_t m_nodes = 0;
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef __PROMISE_ALLOCATOR_HPP__
+#define __PROMISE_ALLOCATOR_HPP__
+
+#include "frame_allocator.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+using std::size_t;
+
+/**
+ * Frame allocation for task and generator promises
+ *
+ * A promise deriving from allocator_aware_promise takes its coroutine
+ * frame from DefaultAllocator, a thread-local recycling pool unless told
+ * otherwise, instead of the global heap.  A coroutine may pick its own
+ * allocator by taking std::allocator_arg_t first, after the object for
+ * member functions:
+ *
+ *     task<int> f(std::allocator_arg_t, Alloc const& alloc, int x);
+ *
+ * Every frame is preceded by the function that frees it and the size the
+ * compiler asked for, and followed by a copy of the allocator when it has
+ * state
+ *
+ *     | frame_prefix | frame | allocator |
+ *
+ * so a frame is freed from its address alone.  That is all the placement
+ * forms of operator delete, matching the allocator_arg forms of operator
+ * new, get to see.
+ */
+template<typename DefaultAllocator = pooled_frame_allocator<>>
+struct allocator_aware_promise
+{
+    static void * operator new(size_t size)
+    {
+        void * mem = DefaultAllocator::allocate(sizeof(frame_prefix) + size);
+        return set_prefix(mem, size, &deallocate_default);
+    }
+
+    template<typename Allocator, typename... ArgTypes>
+    static void * operator new(size_t size, std::allocator_arg_t,
+        Allocator const & alloc, ArgTypes const &...)
+    { return allocate_with(size, alloc); }
+
+    // member function coroutines see the object first
+    template<typename This, typename Allocator, typename... ArgTypes>
+    static void * operator new(size_t size, This const &,
+        std::allocator_arg_t, Allocator const & alloc, ArgTypes const &...)
+    { return allocate_with(size, alloc); }
+
+    static void operator delete(void * frame, size_t)
+    { deallocate(frame); }
+
+    // match the placement forms of operator new above
+    template<typename Allocator, typename... ArgTypes>
+    static void operator delete(void * frame, std::allocator_arg_t,
+        Allocator const &, ArgTypes const &...)
+    { deallocate(frame); }
+
+    template<typename This, typename Allocator, typename... ArgTypes>
+    static void operator delete(void * frame, This const &,
+        std::allocator_arg_t, Allocator const &, ArgTypes const &...)
+    { deallocate(frame); }
+
+private:
+    using deallocate_fn = void (*)(void *, size_t);
+
+    // frames are aligned for any allocation without extended alignment
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_block
+    { char m_bytes[__STDCPP_DEFAULT_NEW_ALIGNMENT__]; };
+
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_prefix
+    {
+        deallocate_fn m_deallocate;
+        size_t m_size; // of the frame
+    };
+
+    static constexpr size_t align_up(size_t size, size_t alignment)
+    { return (size + alignment - 1) & ~(alignment - 1); }
+
+    // returns the frame following the prefix at mem
+    static void * set_prefix(void * mem, size_t size, deallocate_fn fn)
+    {
+        ::new(mem) frame_prefix{fn, size};
+        return static_cast<char*>(mem) + sizeof(frame_prefix);
+    }
+
+    static void deallocate(void * frame)
+    {
+        auto * prefix = std::launder(reinterpret_cast<frame_prefix*>(
+            static_cast<char*>(frame) - sizeof(frame_prefix)));
+        prefix->m_deallocate(prefix, prefix->m_size);
+    }
+
+    static void deallocate_default(void * mem, size_t size)
+    { DefaultAllocator::deallocate(mem, sizeof(frame_prefix) + size); }
+
+    template<typename Allocator>
+    using block_allocator = std::allocator_traits<Allocator>::template
+        rebind_alloc<frame_block>;
+
+    // an allocator without state is rebuilt rather than stored
+    template<typename Allocator>
+    static constexpr bool stores_allocator =
+        !(std::is_empty_v<block_allocator<Allocator>> &&
+          std::is_default_constructible_v<block_allocator<Allocator>>);
+
+    // from the start of the prefix
+    template<typename Allocator>
+    static constexpr size_t allocator_offset(size_t size)
+    {
+        return align_up(sizeof(frame_prefix) + size,
+            alignof(block_allocator<Allocator>));
+    }
+
+    template<typename Allocator>
+    static constexpr size_t block_count(size_t size)
+    {
+        size_t total = sizeof(frame_prefix) + size;
+        if constexpr(stores_allocator<Allocator>)
+            total = allocator_offset<Allocator>(size) +
+                sizeof(block_allocator<Allocator>);
+
+        return (total + sizeof(frame_block) - 1) / sizeof(frame_block);
+    }
+
+    template<typename Allocator>
+    static void * allocate_with(size_t size, Allocator const & alloc)
+    {
+        using alloc_type = block_allocator<Allocator>;
+        using traits = std::allocator_traits<alloc_type>;
+
+        alloc_type a(alloc);
+        void * mem = traits::allocate(a, block_count<Allocator>(size));
+
+        if constexpr(stores_allocator<Allocator>)
+            ::new(static_cast<char*>(mem) + allocator_offset<Allocator>(size))
+                alloc_type(std::move(a));
+
+        return set_prefix(mem, size, &deallocate_with<Allocator>);
+    }
+
+    template<typename Allocator>
+    static void deallocate_with(void * mem, size_t size)
+    {
+        using alloc_type = block_allocator<Allocator>;
+        using traits = std::allocator_traits<alloc_type>;
+
+        auto * blocks = static_cast<frame_block*>(mem);
+        if constexpr(stores_allocator<Allocator>)
+        {
+            auto * stored = std::launder(reinterpret_cast<alloc_type*>(
+                static_cast<char*>(mem) + allocator_offset<Allocator>(size)));
+
+            // the allocator lives in the memory it frees
+            alloc_type a(std::move(*stored));
+            stored->~alloc_type();
+            traits::deallocate(a, blocks, block_count<Allocator>(size));
+        }
+        else
+        {
+            alloc_type a{};
+            traits::deallocate(a, blocks, block_count<Allocator>(size));
+        }
+    }
+};
+
+#endif
@@ -2,15 +2,71 @@
 #define __SAVEABLE_COROUTINE_H__
 
 
+#include "frame_allocator.hpp"
+#include "frame_trace.hpp"
+#include "snapshot_codec.hpp"
+#include "checksum.hpp"
+
 #include <coroutine>
 #include <iostream>
+#include <vector>
+#include <span>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+#include <cstdint>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#include <climits>
+#include <cerrno>
+#endif
 
 using std::size_t;
 
 using version_t = unsigned long;
 
-static constexpr inline version_t saveable_coroutine_version = 0x00'00'0001;
+static constexpr inline version_t saveable_coroutine_version = 0x00'00'0003;
+
+// frame data in memory and in snapshots is aligned to frame_alignment so a
+// snapshot held in suitably aligned memory can be resumed in place
+static constexpr inline size_t frame_alignment = 16;
+
+static constexpr size_t padded_frame_size(size_t data_size)
+{ return (data_size + frame_alignment - 1) & ~(frame_alignment - 1); }
+
+// upper bounds a snapshot is checked against before anything is allocated
+// for it
+static constexpr inline size_t max_frame_data_size = size_t(1) << 26;
+static constexpr inline size_t max_snapshot_frames = size_t(1) << 20;
+
+enum frame_flags : std::uint32_t {
+    frame_in_place = 0x1, // frame lives inside a snapshot, never deallocated
+    frame_compressed = 0x2, // saved frame data is lz_codec compressed
+};
+
+enum class snapshot_encoding {
+    raw,
+    lz,   // frames that shrink are stored lz_codec compressed
+};
 
+/**
+ * A snapshot is the sequence of frames of an await chain, outermost first.
+ * Each frame is its frame_header followed by data_size bytes of frame data
+ * padded with zeros to padded_frame_size(data_size).  The header of every
+ * saved frame holds the number of frames left in the chain (including 
+ * itself) in place of the child address.
+ *
+ * A frame flagged frame_compressed stores its data compressed, size then 
+ * holds the length of the compressed data, which is padded instead.
+ *
+ * checksum is the crc32c of the saved header (with a zero checksum) and
+ * the data that follows it before padding, seeded with the checksum of the
+ * frame before, so the checksum of the last frame covers the whole
+ * snapshot.
+ */
 struct frame_header {
     size_t size;
     size_t data_size;
@@ -21,11 +77,50 @@ struct frame_header {
         void * child_address;
         size_t frame_count;
     };
+
+    std::uint32_t flags;
+    std::uint32_t checksum; // of a saved frame
 };
 
+static_assert(sizeof(frame_header) % frame_alignment == 0, 
+    "frame data must stay aligned behind its header");
+
+// number of bytes following a saved header, before padding
+static constexpr size_t snapshot_payload_size(frame_header const & header)
+{ return header.flags & frame_compressed ? header.size : header.data_size; }
+
+// the checksum of a saved frame given the checksum of the frame before it
+inline std::uint32_t frame_checksum(frame_header const & header,
+    char const * payload, std::uint32_t previous)
+{
+    frame_header h = header;
+    h.checksum = 0;
+
+    std::uint32_t checksum = crc32c::update(previous, &h, sizeof(h));
+    return crc32c::update(checksum, payload, snapshot_payload_size(header));
+}
+
 template<typename HandleType, typename... ArgTypes>
 struct saveable_promise;
 
+// customization point for saveable coroutines returning HandleType
+//
+// allocator_type allocates every frame of the coroutine, including frames
+// restored by load_coro.  frames of one await chain are restored with the
+// allocator of the outermost coroutine so every coroutine of a chain must
+// share the same allocator_type.
+//
+// trace_type receives the frame lifecycle events (see frame_trace.hpp).
+//
+// specializations can derive from saveable_traits<void> to keep the
+// defaults they don't override.
+template<typename HandleType>
+struct saveable_traits
+{
+    using allocator_type = pooled_frame_allocator<>;
+    using trace_type = default_frame_trace;
+};
+
 // template<typename Awaitable>
 // struct awaitable_reference
 // {
@@ -55,23 +150,48 @@ struct saveable_promise<void>
     static void * frame_start(void * address)
     { return reinterpret_cast<char*>(address) - sizeof(frame_header); }
 
-    static void operator delete(void * addr)
-    {
-        void * mem = reinterpret_cast<char*>(addr) - sizeof(frame_header);
-        ::operator delete(mem);
-    }
+    using allocator_type = saveable_traits<void>::allocator_type;
+    using trace_type = saveable_traits<void>::trace_type;
 
-    static void * operator new(size_t size, frame_header const & header)
+    // allocates a frame described by a saved header using Allocator
+    template<typename Allocator>
+    static void * allocate_frame(frame_header const & header)
     {
         //                  | header             | data 
         size_t frame_size = sizeof(frame_header) + header.data_size;
-        void * mem = ::operator new(frame_size);
+        void * mem = Allocator::allocate(frame_size);
 
+        // the child is linked once it has been restored
         *reinterpret_cast<frame_header*>(mem) = header;
+        reinterpret_cast<frame_header*>(mem)->size = frame_size;
+        reinterpret_cast<frame_header*>(mem)->child_address = nullptr;
+        reinterpret_cast<frame_header*>(mem)->flags = 0;
 
-        std::cerr << "saveable_promise new(size, header): " << std::hex << reinterpret_cast<void*>(reinterpret_cast<char*>(mem) + sizeof(frame_header)) << std::endl;
         return reinterpret_cast<char*>(mem) + sizeof(frame_header);
     }
+
+    template<typename Allocator>
+    static void deallocate_frame(void * addr)
+    {
+        frame_header * header = header_from(addr);
+
+        // owned by the snapshot it was restored from
+        if(header->flags & frame_in_place)
+            return;
+
+        Allocator::deallocate(header, header->size);
+    }
+
+    static void operator delete(void * addr)
+    { deallocate_frame<allocator_type>(addr); }
+
+    static void * operator new(size_t, frame_header const & header)
+    {
+        void * addr = allocate_frame<allocator_type>(header);
+
+        trace_type::record(frame_event::restore, addr, header.data_size);
+        return addr;
+    }
 };
 
 struct saveable_base
@@ -79,39 +199,184 @@ struct saveable_base
     frame_header * get_header()
     { return saveable_promise<void>::header_from(m_address); }
 
-    void save(std::ostream & os)
+    // number of frames in the await chain starting at this coroutine
+    size_t frame_count() const
     {
-        size_t frame_count = 1;
-        frame_header * header = get_header();
-
-        for(frame_header * h = header; h->child_address != nullptr; ++frame_count)
-            h = saveable_promise<void>::header_from(h->child_address);
+        size_t frame_count = 0;
+        for(void * addr = m_address; addr != nullptr; ++frame_count)
+            addr = saveable_promise<void>::header_from(addr)->child_address;
+        return frame_count;
+    }
 
-        // first write out the number of frames
-        os.write(reinterpret_cast<char*>(&frame_count), sizeof(size_t));
+    // size in bytes of the snapshot written by save
+    size_t snapshot_size() const
+    {
+        size_t size = 0;
+        for(void * addr = m_address; addr != nullptr; )
+        {
+            frame_header * header = saveable_promise<void>::header_from(addr);
+            size += sizeof(frame_header) + padded_frame_size(header->data_size);
+            addr = header->child_address;
+        }
+        return size;
+    }
 
+    // calls fn(header, data) for every frame of the chain, outermost first,
+    // with the header as it is written to a snapshot
+    template<typename Fn>
+    void for_each_frame(Fn && fn) const
+    {
+        size_t frame_count = this->frame_count();
         frame_header wh;
-        
-        // the write out all the frames
-        for(void * addr = m_address; ; --frame_count)
+
+        for(void * addr = m_address; addr != nullptr; --frame_count)
         {
+            frame_header * header = saveable_promise<void>::header_from(addr);
+
             wh = *header;
-            // wh.child_address = nullptr;
             wh.frame_count = frame_count;
+            wh.flags = 0;
+            wh.checksum = 0;
+            fn(wh, static_cast<char const *>(addr));
+
+            addr = header->child_address;
+        }
+    }
+
+    void save(std::ostream & os, 
+        snapshot_encoding encoding = snapshot_encoding::raw) const
+    {
+        std::uint32_t checksum = 0;
+        for_each_frame([&os, encoding, &checksum](frame_header wh, 
+            char const * data) 
+        {
+            data = encode_frame(wh, data, encoding);
+            seal_frame(wh, data, checksum);
+            size_t payload = snapshot_payload_size(wh);
 
             // write out the header
-            os.write(reinterpret_cast<char*>(&wh), sizeof(frame_header));
+            os.write(reinterpret_cast<char const*>(&wh), sizeof(frame_header));
             
-            // write out the data
-            os.write(reinterpret_cast<char*>(addr), header->data_size);
+            // write out the data and its padding
+            os.write(data, payload);
+            os.write(s_padding, padded_frame_size(payload) - payload);
+        });
+    }
 
-            addr = header->child_address;
-            if(addr == nullptr)
-                break;
+    // writes the snapshot into buffer, which must hold at least 
+    // snapshot_size() bytes, and returns the number of bytes written
+    size_t save(char * buffer) const
+    {
+        char * p = buffer;
+        std::uint32_t checksum = 0;
+
+        for_each_frame([&p, &checksum](frame_header wh, char const * data) 
+        {
+            size_t padded = padded_frame_size(wh.data_size);
+            seal_frame(wh, data, checksum);
+
+            std::memcpy(p, &wh, sizeof(frame_header));
+            p += sizeof(frame_header);
+            std::memcpy(p, data, wh.data_size);
+            std::memset(p + wh.data_size, 0, padded - wh.data_size);
+            p += padded;
+        });
+
+        return p - buffer;
+    }
+
+    // appends the snapshot to buffer
+    void save(std::vector<char> & buffer, snapshot_encoding encoding) const
+    {
+        if(encoding == snapshot_encoding::raw)
+        {
+            size_t at = buffer.size();
+            buffer.resize(at + snapshot_size());
+            save(buffer.data() + at);
+            return;
+        }
+
+        std::uint32_t checksum = 0;
+        for_each_frame([&buffer, encoding, &checksum](frame_header wh, 
+            char const * data) 
+        {
+            data = encode_frame(wh, data, encoding);
+            seal_frame(wh, data, checksum);
+            size_t payload = snapshot_payload_size(wh);
+
+            size_t at = buffer.size();
+            buffer.resize(at + sizeof(frame_header) + padded_frame_size(payload));
+            std::memcpy(buffer.data() + at, &wh, sizeof(frame_header));
+            std::memcpy(buffer.data() + at + sizeof(frame_header), data, 
+                payload);
+        });
+    }
+
+    std::vector<char> snapshot(
+        snapshot_encoding encoding = snapshot_encoding::raw) const
+    {
+        std::vector<char> buffer;
+        save(buffer, encoding);
+        return buffer;
+    }
+
+    // same as save(std::ostream &) but gathers the whole chain into one
+    // buffer first and hands it to the stream with a single write
+    void save_buffered(std::ostream & os, 
+        snapshot_encoding encoding = snapshot_encoding::raw) const
+    {
+        thread_local std::vector<char> s_buffer;
 
-            header = saveable_promise<void>::header_from(header->child_address);
+        s_buffer.clear();
+        save(s_buffer, encoding);
+        os.write(s_buffer.data(), s_buffer.size());
+    }
+
+#if __has_include(<sys/uio.h>)
+    // writes the snapshot to a file descriptor with one writev per IOV_MAX 
+    // vectors without copying any frame data
+    void save(int fd) const
+    {
+        std::vector<frame_header> headers;
+        std::vector<iovec> iov;
+        headers.reserve(frame_count());
+        iov.reserve(3 * headers.capacity());
+
+        std::uint32_t checksum = 0;
+        for_each_frame([&](frame_header wh, char const * data) 
+        {
+            seal_frame(wh, data, checksum);
+            headers.push_back(wh);
+            iov.push_back({&headers.back(), sizeof(frame_header)});
+            iov.push_back({const_cast<char*>(data), wh.data_size});
+            if(size_t pad = padded_frame_size(wh.data_size) - wh.data_size)
+                iov.push_back({const_cast<char*>(s_padding), pad});
+        });
+
+        for(iovec * v = iov.data(), * e = v + iov.size(); v != e; )
+        {
+            int count = (int)std::min<size_t>(e - v, IOV_MAX);
+            ssize_t written = ::writev(fd, v, count);
+            if(written < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), 
+                    "writev");
+            }
+
+            // skip everything written, partially written vectors are
+            // advanced in place
+            for(; v != e && (size_t)written >= v->iov_len; ++v)
+                written -= v->iov_len;
+            if(v != e)
+            {
+                v->iov_base = static_cast<char*>(v->iov_base) + written;
+                v->iov_len -= written;
+            }
         }
     }
+#endif
 
     saveable_base(void * address) : m_address{address} { }
 
@@ -119,6 +384,36 @@ struct saveable_base
     { return m_address; }
 
     void * m_address;
+
+private:
+    // fills in the checksum of a frame about to be saved, checksum holds
+    // the checksum of the frame saved before it
+    static void seal_frame(frame_header & wh, char const * payload,
+        std::uint32_t & checksum)
+    { wh.checksum = checksum = frame_checksum(wh, payload, checksum); }
+
+    // compresses the frame data if asked to and it pays off, updating the
+    // header to match, returns the data to write
+    static char const * encode_frame(frame_header & wh, char const * data,
+        snapshot_encoding encoding)
+    {
+        if(encoding != snapshot_encoding::lz)
+            return data;
+
+        thread_local std::vector<char> s_compressed;
+        s_compressed.resize(lz_codec::max_compressed_size(wh.data_size));
+
+        size_t size = 
+            lz_codec::compress(data, wh.data_size, s_compressed.data());
+        if(padded_frame_size(size) >= padded_frame_size(wh.data_size))
+            return data;
+
+        wh.flags |= frame_compressed;
+        wh.size = size;
+        return s_compressed.data();
+    }
+
+    static constexpr char s_padding[frame_alignment] = {};
 };
 
 template<typename HandleType>
@@ -181,11 +476,14 @@ struct saveable_promise :
         using type = std::tuple_element_t<I, std::tuple<ArgTypes...>>;
     };
 
+    using allocator_type = saveable_traits<HandleType>::allocator_type;
+    using trace_type = saveable_traits<HandleType>::trace_type;
+
     static void * operator new(size_t size)
     {
         //                  | header             | data 
         size_t frame_size = sizeof(frame_header) + size;
-        void * mem = ::operator new(frame_size);
+        void * mem = allocator_type::allocate(frame_size);
 
         *reinterpret_cast<frame_header*>(mem) = {
             .size = frame_size,
@@ -193,18 +491,21 @@ struct saveable_promise :
             .version = saveable_coroutine_version,
             .hash_code = typeid(saveable_promise).hash_code(),
             .child_address = nullptr,
+            .flags = 0,
+            .checksum = 0,
         };
 
-        std::cerr << "saveable_promise new(size): " << std::hex << reinterpret_cast<void*>(reinterpret_cast<char*>(mem) + sizeof(frame_header)) << std::endl;
-        return reinterpret_cast<char*>(mem) + sizeof(frame_header);
+        void * addr = reinterpret_cast<char*>(mem) + sizeof(frame_header);
+
+        trace_type::record(frame_event::allocate, addr, size);
+        return addr;
     }
 
     static void operator delete(void * addr)
     {
-        void * mem = reinterpret_cast<char*>(addr) - sizeof(frame_header);
-        ::operator delete(mem);
+        trace_type::record(frame_event::deallocate, addr);
 
-        std::cerr << "promise_type delete: " << std::hex << addr << std::endl;
+        saveable_promise<void>::deallocate_frame<allocator_type>(addr);
     }
 
     static frame_header * header_from(void * address) 
@@ -311,7 +612,7 @@ struct saveable_promise :
         int i = 0;
         ( ( m_argument_offset[i++] = (reinterpret_cast<char*>(&args) - reinterpret_cast<char*>(address)) ), ... );
 
-        std::cerr << "promise_type coroutine construtor" << std::endl;
+        trace_type::record(frame_event::construct, address);
     } 
     
     
@@ -319,14 +620,16 @@ struct saveable_promise :
         std::coroutine_traits<HandleType, ArgTypes...>::promise_type{},
         m_suspended{false}
     { 
-        std::cerr << "promise_type header constructor" << std::endl;
+        trace_type::record(frame_event::construct_from_header, 
+            std::coroutine_handle<saveable_promise>::from_promise(*this).address());
     }
     
     saveable_promise() : 
         std::coroutine_traits<HandleType, ArgTypes...>::promise_type{},
         m_suspended{false}
     { 
-        std::cerr << "promise_type default constructor" << std::endl;
+        trace_type::record(frame_event::default_construct, 
+            std::coroutine_handle<saveable_promise>::from_promise(*this).address());
     }
 
     //...
@@ -337,72 +640,365 @@ struct saveable_promise :
     }; }
 
     ~saveable_promise()
-    { std::cerr << "promise_type destructor: " << std::hex << std::coroutine_handle<saveable_promise>::from_promise(*this).address() << std::endl; }
+    { 
+        trace_type::record(frame_event::destruct, 
+            std::coroutine_handle<saveable_promise>::from_promise(*this).address()); 
+    }
 
     long m_argument_offset[sizeof...(ArgTypes)];
     bool m_suspended;
 };
 
-template<typename HandleType, typename... ArgTypes>
-saveable<HandleType> load_coro(std::istream & is, ArgTypes  &... args)
+// checks the outermost frame of a snapshot was saved by Promise
+template<typename Promise>
+void check_snapshot_header(frame_header const & header)
 {
-    using promise_type = saveable_promise<HandleType, ArgTypes...>;
+    // check the version and hash code
+    if(header.version != saveable_coroutine_version)
+        throw std::logic_error("version mismatch");
 
-    // first read in the number of frames
-    size_t frame_count;
-    is.read(reinterpret_cast<char*>(&frame_count), sizeof(size_t));
+    if(header.hash_code != typeid(Promise).hash_code())
+        throw std::logic_error("hash_code mismatch");
+
+    if(header.frame_count == 0)
+        throw std::logic_error("empty snapshot");
+
+    if(header.frame_count > max_snapshot_frames)
+        throw std::logic_error("corrupt snapshot");
+}
+
+// checks what a saved header claims before anything is allocated for its
+// frame, frame_count is the number of frames left in the snapshot
+inline void check_frame_header(frame_header const & header, 
+    size_t frame_count)
+{
+    if(header.frame_count != frame_count || 
+       (header.flags & ~frame_compressed) != 0 ||
+       header.data_size > max_frame_data_size)
+        throw std::logic_error("corrupt snapshot");
+
+    if((header.flags & frame_compressed) &&
+       header.size > lz_codec::max_compressed_size(header.data_size))
+        throw std::logic_error("corrupt snapshot");
+}
+
+// checks the checksum of a saved frame given the checksum of the frame 
+// before it, returns it for the next frame
+inline std::uint32_t check_frame_checksum(frame_header const & header,
+    char const * payload, std::uint32_t previous)
+{
+    std::uint32_t checksum = frame_checksum(header, payload, previous);
+    if(checksum != header.checksum)
+        throw std::logic_error("checksum mismatch");
+    return checksum;
+}
+
+// links a freshly restored frame into the chain being loaded
+inline void link_restored_frame(void * address, void *& return_address, 
+    frame_header *& prev_header)
+{
+    if(return_address == nullptr)
+        return_address = address;
+    else
+        prev_header->child_address = address;
+
+    prev_header = saveable_promise<void>::header_from(address);
+}
+
+// hydrates the arguments of the outermost frame once the whole chain has
+// been restored
+template<typename Promise, typename... ArgTypes>
+void hydrate_restored(void * address, ArgTypes &... args)
+{
+    auto cohandle = std::coroutine_handle<Promise>::from_address(address);
+    cohandle.promise().hydrate_arguments(args...);
+}
+
+// frees the frames of a chain that failed to restore, nothing in them has
+// run so they are not destroyed
+template<typename Allocator>
+void discard_restored_frames(void * address)
+{
+    while(address != nullptr)
+    {
+        void * child = 
+            saveable_promise<void>::header_from(address)->child_address;
+        saveable_promise<void>::deallocate_frame<Allocator>(address);
+        address = child;
+    }
+}
+
+// checks the frame sizes and checksums of a snapshot held in memory in one
+// pass without restoring it, returns the number of frames
+inline size_t validate_snapshot(std::span<char const> snapshot)
+{
+    char const * p = snapshot.data();
+    char const * e = p + snapshot.size();
 
-    frame_header * prev_header = nullptr;
-    void * return_address = nullptr;
     frame_header header;
+    std::uint32_t checksum = 0;
+    size_t frames = 0;
 
-    for(; frame_count > 0; --frame_count)
+    for(size_t frame_count = 1; frame_count > 0; --frame_count, ++frames)
     {
-        // read in the header
-        is.read(reinterpret_cast<char*>(&header), sizeof(frame_header));
+        if((size_t)(e - p) < sizeof(frame_header))
+            throw std::logic_error("truncated snapshot");
+        std::memcpy(&header, p, sizeof(frame_header));
+        p += sizeof(frame_header);
 
-        // if this is the first header, check the version and hash
-        if(return_address == nullptr) 
+        if(frames == 0)
         {
-            // check the version and hash code
             if(header.version != saveable_coroutine_version)
                 throw std::logic_error("version mismatch");
-
-            if(header.hash_code != typeid(promise_type).hash_code())
-                throw std::logic_error("hash_code mismatch");
+            if(header.frame_count == 0)
+                throw std::logic_error("empty snapshot");
+            frame_count = header.frame_count;
         }
-        
-        // allocate the memory for the frame using the dedicated allocator
-        void * address = 
-            saveable_promise<void>::operator new(header.data_size, header); //, args...);
+        check_frame_header(header, frame_count);
+
+        size_t padded = padded_frame_size(snapshot_payload_size(header));
+        if((size_t)(e - p) < padded)
+            throw std::logic_error("truncated snapshot");
+
+        checksum = check_frame_checksum(header, p, checksum);
+        p += padded;
+    }
+
+    return frames;
+}
 
-        // read in the rest of the frame into allocated memory
-        is.read(reinterpret_cast<char*>(address), header.data_size);
+template<typename HandleType, typename... ArgTypes>
+saveable<HandleType> load_coro(std::istream & is, ArgTypes  &... args)
+{
+    using promise_type = saveable_promise<HandleType, ArgTypes...>;
+    using allocator_type = typename promise_type::allocator_type;
 
-        // if this is the first header update the args
-        if(return_address == nullptr)
+    frame_header * prev_header = nullptr;
+    void * return_address = nullptr;
+    void * address = nullptr;
+    frame_header header;
+    std::uint32_t checksum = 0;
+
+    try {
+        // the first header holds the number of frames
+        for(size_t frame_count = 1; frame_count > 0; --frame_count)
         {
-            auto cohandle = 
-                std::coroutine_handle<promise_type>::from_address(address);
+            // read in the header
+            if(!is.read(reinterpret_cast<char*>(&header), 
+                sizeof(frame_header)))
+                throw std::logic_error("truncated snapshot");
+
+            // if this is the first header, check the version and hash
+            if(return_address == nullptr) 
+            {
+                check_snapshot_header<promise_type>(header);
+                frame_count = header.frame_count;
+            }
+            check_frame_header(header, frame_count);
+            
+            // allocate the memory for the frame using the dedicated 
+            // allocator
+            address = saveable_promise<void>::allocate_frame<
+                allocator_type>(header);
+
+            // read in the rest of the frame into allocated memory
+            size_t payload = snapshot_payload_size(header);
+            if(header.flags & frame_compressed)
+            {
+                thread_local std::vector<char> s_compressed;
+                s_compressed.resize(payload);
+                if(!is.read(s_compressed.data(), payload))
+                    throw std::logic_error("truncated snapshot");
+
+                checksum = check_frame_checksum(header, 
+                    s_compressed.data(), checksum);
+                lz_codec::decompress(s_compressed.data(), payload, 
+                    reinterpret_cast<char*>(address), header.data_size);
+            }
+            else
+            {
+                if(!is.read(reinterpret_cast<char*>(address), payload))
+                    throw std::logic_error("truncated snapshot");
+
+                checksum = check_frame_checksum(header, 
+                    reinterpret_cast<char*>(address), checksum);
+            }
 
-            promise_type & promise = cohandle.promise();
+            is.ignore(padded_frame_size(payload) - payload);
 
-            promise.hydrate_arguments(args...);
+            promise_type::trace_type::record(frame_event::restore, address, 
+                header.data_size);
 
-            return_address = address;
+            link_restored_frame(address, return_address, prev_header);
+            address = nullptr;
         }
-        // otherwise set the previous frame's child pointer
-        else
+    } catch(...) {
+        if(address != nullptr)
+            saveable_promise<void>::deallocate_frame<allocator_type>(address);
+        discard_restored_frames<allocator_type>(return_address);
+        throw;
+    }
+
+    hydrate_restored<promise_type>(return_address, args...);
+    return { return_address };
+}
+
+// restores a coroutine from a snapshot held in memory, e.g. written by
+// saveable_base::save(char *) or read with read_snapshot
+//
+// every frame is checked before its memory is allocated
+template<typename HandleType, typename... ArgTypes>
+saveable<HandleType> load_coro(std::span<char const> snapshot, 
+    ArgTypes &... args)
+{
+    using promise_type = saveable_promise<HandleType, ArgTypes...>;
+    using allocator_type = typename promise_type::allocator_type;
+
+    char const * p = snapshot.data();
+    char const * e = p + snapshot.size();
+
+    auto take = [&p, e](size_t size) {
+        if((size_t)(e - p) < size)
+            throw std::logic_error("truncated snapshot");
+        char const * r = p;
+        p += size;
+        return r;
+    };
+
+    frame_header * prev_header = nullptr;
+    void * return_address = nullptr;
+    frame_header header;
+    std::uint32_t checksum = 0;
+
+    try {
+        for(size_t frame_count = 1; frame_count > 0; --frame_count)
+        {
+            std::memcpy(&header, take(sizeof(frame_header)), 
+                sizeof(frame_header));
+
+            if(return_address == nullptr) 
+            {
+                check_snapshot_header<promise_type>(header);
+                if(header.frame_count > snapshot.size() / sizeof(frame_header))
+                    throw std::logic_error("truncated snapshot");
+                frame_count = header.frame_count;
+            }
+            check_frame_header(header, frame_count);
+
+            size_t payload = snapshot_payload_size(header);
+            char const * data = take(padded_frame_size(payload));
+            checksum = check_frame_checksum(header, data, checksum);
+
+            void * address = saveable_promise<void>::allocate_frame<
+                allocator_type>(header);
+
+            // linked first so it is discarded if decompression fails
+            link_restored_frame(address, return_address, prev_header);
+
+            if(header.flags & frame_compressed)
+                lz_codec::decompress(data, payload, 
+                    reinterpret_cast<char*>(address), header.data_size);
+            else
+                std::memcpy(address, data, header.data_size);
+
+            promise_type::trace_type::record(frame_event::restore, address, 
+                header.data_size);
+        }
+    } catch(...) {
+        discard_restored_frames<allocator_type>(return_address);
+        throw;
+    }
+
+    hydrate_restored<promise_type>(return_address, args...);
+    return { return_address };
+}
+
+// restores a coroutine without copying: the frames are resumed right where
+// they sit in the snapshot.  the memory must be writable, aligned to 
+// frame_alignment and outlive the coroutine; its frames are never handed to
+// an allocator.  restoring rewrites the frame headers, so the same memory
+// cannot be restored in place a second time.
+template<typename HandleType, typename... ArgTypes>
+saveable<HandleType> load_coro_in_place(std::span<char> snapshot, 
+    ArgTypes &... args)
+{
+    using promise_type = saveable_promise<HandleType, ArgTypes...>;
+
+    if(reinterpret_cast<std::uintptr_t>(snapshot.data()) % frame_alignment)
+        throw std::logic_error("misaligned snapshot");
+
+    char * p = snapshot.data();
+    char * e = p + snapshot.size();
+
+    frame_header * prev_header = nullptr;
+    void * return_address = nullptr;
+    std::uint32_t checksum = 0;
+
+    for(size_t frame_count = 1; frame_count > 0; --frame_count)
+    {
+        if((size_t)(e - p) < sizeof(frame_header))
+            throw std::logic_error("truncated snapshot");
+
+        frame_header * header = reinterpret_cast<frame_header*>(p);
+        p += sizeof(frame_header);
+
+        if(return_address == nullptr) 
         {
-            prev_header->child_address = address;
+            check_snapshot_header<promise_type>(*header);
+            frame_count = header->frame_count;
         }
+        check_frame_header(*header, frame_count);
+
+        if(header->flags & frame_compressed)
+            throw std::logic_error("compressed snapshots cannot be restored "
+                                   "in place");
+
+        if((size_t)(e - p) < padded_frame_size(header->data_size))
+            throw std::logic_error("truncated snapshot");
+
+        checksum = check_frame_checksum(*header, p, checksum);
 
-        prev_header = saveable_promise<void>::header_from(address);
+        void * address = p;
+        p += padded_frame_size(header->data_size);
+
+        header->size = sizeof(frame_header) + header->data_size;
+        header->child_address = nullptr;
+        header->flags = frame_in_place;
+
+        promise_type::trace_type::record(frame_event::restore, address, 
+            header->data_size);
+
+        link_restored_frame(address, return_address, prev_header);
     }
 
+    hydrate_restored<promise_type>(return_address, args...);
     return { return_address };
 }
 
+// reads everything left in the stream with a single read so it can be
+// handed to load_coro(std::span<char const>, ...)
+inline std::vector<char> read_snapshot(std::istream & is)
+{
+    std::vector<char> buffer;
+
+    auto cur = is.tellg();
+    if(cur != std::istream::pos_type(-1) && is.seekg(0, std::ios::end))
+    {
+        auto end = is.tellg();
+        is.seekg(cur);
+
+        buffer.resize(end - cur);
+        is.read(buffer.data(), buffer.size());
+        return buffer;
+    }
+
+    // not seekable
+    is.clear();
+    buffer.assign(std::istreambuf_iterator<char>(is), 
+        std::istreambuf_iterator<char>());
+    return buffer;
+}
+
 namespace std {
     // promise_type for saveable with arguments to coroutine
     template<typename HandleType, typename... ArgTypes>
@@ -0,0 +1,180 @@
+#ifndef __SCHEDULER_HPP__
+#define __SCHEDULER_HPP__
+
+#include "task.hpp"
+#include "thread_pool.hpp"
+
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <variant>
+
+/**
+ * Scheduler
+ *
+ * Moves coroutines onto a work_stealing_pool:
+ *
+ *     co_await sched.schedule(); // now running on one of the pool's threads
+ *
+ * The schedule operation lives in the suspended coroutine's frame and is
+ * posted to the pool as is, so a hop allocates nothing.
+ */
+class scheduler
+{
+public:
+    explicit scheduler(work_stealing_pool & pool) : m_pool{&pool} { }
+
+    struct schedule_operation : pool_work
+    {
+        explicit schedule_operation(work_stealing_pool & pool) :
+            pool_work{&schedule_operation::run}, m_pool{&pool}, m_handle{}
+        { }
+
+        bool await_ready() const noexcept
+        { return false; }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_handle = handle;
+            m_pool->post(*this);
+        }
+
+        void await_resume() const noexcept
+        { }
+
+    private:
+        static void run(pool_work * work)
+        { static_cast<schedule_operation*>(work)->m_handle.resume(); }
+
+        work_stealing_pool * m_pool;
+        std::coroutine_handle<> m_handle;
+    };
+
+    schedule_operation schedule() const noexcept
+    { return schedule_operation{*m_pool}; }
+
+    work_stealing_pool & pool() const noexcept
+    { return *m_pool; }
+
+    bool operator==(scheduler const &) const = default;
+
+private:
+    work_stealing_pool * m_pool;
+};
+
+// a coroutine nobody awaits, it starts right away and frees itself once it
+// returns.  exceptions escaping it terminate.
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+// runs t on sched
+template<typename T>
+task<T> schedule_on(scheduler sched, task<T> t)
+{
+    co_await sched.schedule();
+    co_return co_await std::move(t);
+}
+
+inline task<void> schedule_on(scheduler sched, task<void> t)
+{
+    co_await sched.schedule();
+    co_await std::move(t);
+}
+
+// runs t where it is awaited and resumes the awaiting coroutine on sched
+template<typename T>
+task<T> resume_on(scheduler sched, task<T> t)
+{
+    T result = co_await std::move(t);
+    co_await sched.schedule();
+    co_return result;
+}
+
+inline task<void> resume_on(scheduler sched, task<void> t)
+{
+    co_await std::move(t);
+    co_await sched.schedule();
+}
+
+// starts t on sched without waiting for it, t must handle its own errors
+template<typename T>
+detached_task spawn(scheduler sched, task<T> t)
+{
+    co_await sched.schedule();
+    co_await std::move(t);
+}
+
+/**
+ * sync_wait blocks the calling thread until a task completes, wherever the
+ * task ends up running.  task::get() only resumes the task in place and
+ * returns early once the task moves to another thread.
+ *
+ * Never call it on a pool thread the task needs to make progress.
+ */
+template<typename T>
+struct sync_wait_state
+{
+    using result_type = std::conditional_t<std::is_void_v<T>, 
+        std::monostate, T>;
+
+    std::variant<std::monostate, result_type, std::exception_ptr> m_result;
+    bool m_done = false;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+
+    // the waiter may return as soon as the lock is released, nothing here
+    // is touched after that
+    void complete()
+    {
+        std::lock_guard lock(m_mutex);
+        m_done = true;
+        m_cond.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock lock(m_mutex);
+        m_cond.wait(lock, [this]{ return m_done; });
+    }
+};
+
+template<typename T>
+detached_task sync_wait_body(task<T> t, sync_wait_state<T> & state)
+{
+    try {
+        if constexpr(std::is_void_v<T>)
+            co_await std::move(t);
+        else
+            state.m_result.template emplace<1>(co_await std::move(t));
+    } catch(...) {
+        state.m_result.template emplace<2>(std::current_exception());
+    }
+    state.complete();
+}
+
+template<typename T>
+T sync_wait(task<T> t)
+{
+    sync_wait_state<T> state;
+    sync_wait_body(std::move(t), state);
+    state.wait();
+
+    if(state.m_result.index() == 2)
+        std::rethrow_exception(std::get<2>(state.m_result));
+
+    if constexpr(!std::is_void_v<T>)
+        return std::move(std::get<1>(state.m_result));
+}
+
+#endif
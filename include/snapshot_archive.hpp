@@ -0,0 +1,318 @@
+#ifndef __SNAPSHOT_ARCHIVE_HPP__
+#define __SNAPSHOT_ARCHIVE_HPP__
+
+#include "saveable_coroutine.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <span>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+/**
+ * A snapshot archive stores the snapshots of many coroutines in one file
+ *
+ *     | archive_header | archive_entry * entry_count | snapshots ... |
+ *
+ * The index is sorted by id so a single coroutine is found with a binary
+ * search and restored without reading any other snapshot.  Offsets are
+ * relative to the start of the archive and aligned to frame_alignment, so
+ * an archive held in aligned memory (e.g. a mapped_snapshot) can be
+ * restored in place.
+ */
+static constexpr inline std::uint64_t snapshot_archive_magic =
+    0x31'56'48'43'52'41'43'53; // "SCARCHV1"
+
+using snapshot_id = std::uint64_t;
+
+struct archive_header
+{
+    std::uint64_t magic;
+    version_t version;
+    std::uint64_t entry_count;
+    std::uint64_t size; // of the whole archive
+};
+
+struct archive_entry
+{
+    snapshot_id id;
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::uint64_t hash_code; // of the outermost frame
+
+    bool operator<(archive_entry const & other) const
+    { return id < other.id; }
+};
+
+static_assert((sizeof(archive_header) + sizeof(archive_entry))
+    % frame_alignment == 0, "snapshots must stay aligned in an archive");
+
+// collects coroutines and writes them out as one archive
+//
+// the writer only refers to the coroutines, they must stay alive and
+// unchanged until write returns
+class snapshot_archive_writer
+{
+public:
+    void add(snapshot_id id, saveable_base const & coroutine)
+    { m_items.push_back({id, coroutine.address()}); }
+
+    size_t size() const
+    { return m_items.size(); }
+
+    void clear()
+    { m_items.clear(); }
+
+    // compressed snapshots are encoded up front to learn their size
+    void write(std::ostream & os, 
+        snapshot_encoding encoding = snapshot_encoding::raw)
+    {
+        std::sort(m_items.begin(), m_items.end());
+
+        std::vector<std::vector<char>> encoded;
+        if(encoding != snapshot_encoding::raw)
+        {
+            encoded.reserve(m_items.size());
+            for(auto const & item : m_items)
+                encoded.push_back(
+                    saveable_base{item.m_address}.snapshot(encoding));
+        }
+
+        archive_header header = {
+            .magic = snapshot_archive_magic,
+            .version = saveable_coroutine_version,
+            .entry_count = m_items.size(),
+            .size = 0,
+        };
+
+        std::vector<archive_entry> index;
+        index.reserve(m_items.size());
+
+        std::uint64_t offset =
+            sizeof(archive_header) + sizeof(archive_entry) * m_items.size();
+
+        for(size_t i = 0; i < m_items.size(); ++i)
+        {
+            auto const & item = m_items[i];
+            if(!index.empty() && index.back().id == item.m_id)
+                throw std::logic_error("duplicate snapshot id");
+
+            saveable_base coroutine{item.m_address};
+            std::uint64_t size = encoded.empty() 
+                ? coroutine.snapshot_size() : encoded[i].size();
+
+            index.push_back({
+                .id = item.m_id,
+                .offset = offset,
+                .size = size,
+                .hash_code = coroutine.get_header()->hash_code,
+            });
+            offset += size;
+        }
+        header.size = offset;
+
+        os.write(reinterpret_cast<char const *>(&header), sizeof(header));
+        os.write(reinterpret_cast<char const *>(index.data()),
+            sizeof(archive_entry) * index.size());
+
+        if(!encoded.empty())
+        {
+            for(auto const & snapshot : encoded)
+                os.write(snapshot.data(), snapshot.size());
+            return;
+        }
+
+        for(auto const & item : m_items)
+            saveable_base{item.m_address}.save_buffered(os);
+    }
+
+private:
+    struct item
+    {
+        snapshot_id m_id;
+        void * m_address;
+
+        bool operator<(item const & other) const
+        { return m_id < other.m_id; }
+    };
+
+    std::vector<item> m_items;
+};
+
+// checks an archive header read from storage
+inline void check_archive_header(archive_header const & header)
+{
+    if(header.magic != snapshot_archive_magic)
+        throw std::logic_error("not a snapshot archive");
+
+    if(header.version != saveable_coroutine_version)
+        throw std::logic_error("version mismatch");
+}
+
+// finds id in a sorted index, returns nullptr if it is missing
+inline archive_entry const * find_archive_entry(
+    std::span<archive_entry const> index, snapshot_id id)
+{
+    auto i = std::lower_bound(index.begin(), index.end(),
+        archive_entry{.id = id, .offset = 0, .size = 0, .hash_code = 0});
+
+    if(i == index.end() || i->id != id)
+        return nullptr;
+
+    return &*i;
+}
+
+// checks an index entry names the promise type it is restored as, before
+// any of its snapshot is read
+template<typename Promise>
+void check_archive_entry(archive_entry const & e)
+{
+    if(e.hash_code != typeid(Promise).hash_code())
+        throw std::logic_error("hash_code mismatch");
+}
+
+// restores single coroutines from an archive in a seekable stream
+//
+// only the header and index are read up front, load seeks straight to the
+// requested snapshot
+class snapshot_archive_reader
+{
+public:
+    explicit snapshot_archive_reader(std::istream & is) :
+        m_is{is}, m_base{is.tellg()}, m_index{}
+    {
+        archive_header header;
+        if(!m_is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            throw std::logic_error("truncated snapshot archive");
+
+        check_archive_header(header);
+
+        // bound the index by the stream before allocating it
+        auto at = m_is.tellg();
+        m_is.seekg(0, std::ios::end);
+        std::uint64_t available = m_is.tellg() - at;
+        m_is.seekg(at);
+
+        if(header.entry_count > available / sizeof(archive_entry))
+            throw std::logic_error("truncated snapshot archive");
+
+        m_index.resize(header.entry_count);
+        if(!m_is.read(reinterpret_cast<char*>(m_index.data()),
+            sizeof(archive_entry) * m_index.size()))
+            throw std::logic_error("truncated snapshot archive");
+    }
+
+    std::span<archive_entry const> entries() const
+    { return m_index; }
+
+    bool contains(snapshot_id id) const
+    { return find_archive_entry(m_index, id) != nullptr; }
+
+    archive_entry const & entry(snapshot_id id) const
+    {
+        archive_entry const * e = find_archive_entry(m_index, id);
+        if(e == nullptr)
+            throw std::logic_error("unknown snapshot id");
+        return *e;
+    }
+
+    template<typename HandleType, typename... ArgTypes>
+    saveable<HandleType> load(snapshot_id id, ArgTypes &... args)
+    {
+        archive_entry const & e = entry(id);
+        check_archive_entry<saveable_promise<HandleType, ArgTypes...>>(e);
+
+        m_is.clear();
+        m_is.seekg(m_base + std::streamoff(e.offset));
+
+        return load_coro<HandleType>(m_is, args...);
+    }
+
+private:
+    std::istream & m_is;
+    std::istream::pos_type m_base;
+    std::vector<archive_entry> m_index;
+};
+
+// an archive held in memory, e.g. mapped_snapshot::data()
+//
+// the index is used right where it is, load copies a snapshot into freshly
+// allocated frames and load_in_place resumes it inside the archive memory
+class snapshot_archive_view
+{
+public:
+    explicit snapshot_archive_view(std::span<char> archive) :
+        m_archive{archive}, m_index{}
+    {
+        archive_header header;
+        if(archive.size() < sizeof(header))
+            throw std::logic_error("truncated snapshot archive");
+
+        std::memcpy(&header, archive.data(), sizeof(header));
+        check_archive_header(header);
+
+        if(header.size > archive.size() ||
+           header.entry_count > (archive.size() - sizeof(header))
+                / sizeof(archive_entry))
+            throw std::logic_error("truncated snapshot archive");
+
+        m_index = {
+            reinterpret_cast<archive_entry const *>(
+                archive.data() + sizeof(header)),
+            header.entry_count
+        };
+    }
+
+    std::span<archive_entry const> entries() const
+    { return m_index; }
+
+    bool contains(snapshot_id id) const
+    { return find_archive_entry(m_index, id) != nullptr; }
+
+    archive_entry const & entry(snapshot_id id) const
+    {
+        archive_entry const * e = find_archive_entry(m_index, id);
+        if(e == nullptr)
+            throw std::logic_error("unknown snapshot id");
+        return *e;
+    }
+
+    // the snapshot of one coroutine
+    std::span<char> snapshot(archive_entry const & e) const
+    {
+        if(e.offset > m_archive.size() ||
+           e.size > m_archive.size() - e.offset)
+            throw std::logic_error("truncated snapshot archive");
+
+        return m_archive.subspan(e.offset, e.size);
+    }
+
+    template<typename HandleType, typename... ArgTypes>
+    saveable<HandleType> load(snapshot_id id, ArgTypes &... args) const
+    {
+        archive_entry const & e = entry(id);
+        check_archive_entry<saveable_promise<HandleType, ArgTypes...>>(e);
+
+        return load_coro<HandleType>(std::span<char const>{snapshot(e)}, 
+            args...);
+    }
+
+    template<typename HandleType, typename... ArgTypes>
+    saveable<HandleType> load_in_place(snapshot_id id,
+        ArgTypes &... args) const
+    {
+        archive_entry const & e = entry(id);
+        check_archive_entry<saveable_promise<HandleType, ArgTypes...>>(e);
+
+        return load_coro_in_place<HandleType>(snapshot(e), args...);
+    }
+
+private:
+    std::span<char> m_archive;
+    std::span<archive_entry const> m_index;
+};
+
+#endif
@@ -0,0 +1,198 @@
+#ifndef __SNAPSHOT_CODEC_HPP__
+#define __SNAPSHOT_CODEC_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <cstddef>
+
+using std::size_t;
+
+/**
+ * A small LZ77 byte codec for coroutine frames.
+ *
+ * The compressed stream is a sequence of
+ *
+ *     | token | literal length* | literals | offset | match length* |
+ *
+ * where the high nibble of the token is the literal count, the low nibble
+ * the match length minus min_match, a nibble of 15 continues in extra
+ * bytes (*) that are added up until one is below 255, and offset is a 16
+ * bit little endian distance back into the output.  The last sequence
+ * ends after its literals.  Matches may overlap their own output, which
+ * turns the long zero runs of frame padding into a few bytes.
+ */
+struct lz_codec
+{
+    static constexpr size_t min_match = 4;
+    static constexpr size_t max_offset = 0xffff;
+
+    // worst case size of compressing size bytes
+    static constexpr size_t max_compressed_size(size_t size)
+    { return size + size / 255 + 16; }
+
+    // compresses src into dst, which must hold max_compressed_size(size)
+    // bytes, returns the compressed size
+    static size_t compress(char const * src, size_t size, char * dst)
+    {
+        auto in = reinterpret_cast<unsigned char const *>(src);
+        auto out = reinterpret_cast<unsigned char *>(dst);
+
+        // the table grows with the input so small frames stay cheap
+        unsigned bits = 6;
+        while(bits < 12 && (size_t(1) << bits) < size)
+            ++bits;
+
+        std::uint32_t table[1 << 12];
+        std::fill_n(table, size_t(1) << bits, ~std::uint32_t(0));
+
+        unsigned char * token = nullptr;
+        size_t anchor = 0;
+        size_t i = 0;
+        while(i + min_match <= size)
+        {
+            std::uint32_t h = hash(in + i, bits);
+            size_t candidate = table[h];
+            table[h] = (std::uint32_t)i;
+
+            if(candidate == ~std::uint32_t(0) || i - candidate > max_offset ||
+               std::memcmp(in + candidate, in + i, min_match) != 0)
+            {
+                ++i;
+                continue;
+            }
+
+            size_t length = min_match;
+            while(i + length < size && in[candidate + length] == in[i + length])
+                ++length;
+
+            out = literals(out, token, in + anchor, i - anchor);
+            *out++ = (unsigned char)((i - candidate) & 0xff);
+            *out++ = (unsigned char)((i - candidate) >> 8);
+
+            *token |= (unsigned char)std::min<size_t>(length - min_match, 15);
+            if(length - min_match >= 15)
+                out = extra_bytes(out, length - min_match - 15);
+
+            i += length;
+            anchor = i;
+        }
+
+        // the last sequence is literals only
+        out = literals(out, token, in + anchor, size - anchor);
+        return out - reinterpret_cast<unsigned char *>(dst);
+    }
+
+    // decompresses exactly size bytes into dst, throws on malformed input
+    static void decompress(char const * src, size_t compressed, char * dst,
+        size_t size)
+    {
+        auto in = reinterpret_cast<unsigned char const *>(src);
+        auto end = in + compressed;
+        auto out = reinterpret_cast<unsigned char *>(dst);
+        auto out_end = out + size;
+
+        for(;;)
+        {
+            if(in == end)
+                corrupt();
+
+            unsigned token = *in++;
+
+            size_t literals = read_length(in, end, token >> 4);
+            if((size_t)(end - in) < literals ||
+               (size_t)(out_end - out) < literals)
+                corrupt();
+            if(literals > 0)
+                std::memcpy(out, in, literals);
+            in += literals;
+            out += literals;
+
+            // the last sequence has no match
+            if(in == end)
+                break;
+
+            if(end - in < 2)
+                corrupt();
+            size_t offset = in[0] | (size_t(in[1]) << 8);
+            in += 2;
+
+            size_t length = read_length(in, end, token & 0xf) + min_match;
+            if(offset == 0 ||
+               offset > (size_t)(out - reinterpret_cast<unsigned char *>(dst)) ||
+               (size_t)(out_end - out) < length)
+                corrupt();
+
+            // byte by byte, matches may overlap their output
+            unsigned char const * from = out - offset;
+            for(size_t k = 0; k < length; ++k)
+                out[k] = from[k];
+            out += length;
+        }
+
+        if(out != out_end)
+            corrupt();
+    }
+
+    static std::vector<char> compress(char const * src, size_t size)
+    {
+        std::vector<char> dst(max_compressed_size(size));
+        dst.resize(compress(src, size, dst.data()));
+        return dst;
+    }
+
+private:
+    static std::uint32_t hash(unsigned char const * p, unsigned bits)
+    {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return (v * 2654435761u) >> (32 - bits);
+    }
+
+    // starts a sequence with its token and literals, the match nibble of
+    // the token is filled in once the match is known
+    static unsigned char * literals(unsigned char * out, 
+        unsigned char *& token, unsigned char const * literals, size_t count)
+    {
+        token = out;
+        *out++ = (unsigned char)(std::min<size_t>(count, 15) << 4);
+        if(count >= 15)
+            out = extra_bytes(out, count - 15);
+
+        if(count > 0)
+            std::memcpy(out, literals, count);
+        return out + count;
+    }
+
+    static unsigned char * extra_bytes(unsigned char * out, size_t length)
+    {
+        for(; length >= 255; length -= 255)
+            *out++ = 255;
+        *out++ = (unsigned char)length;
+        return out;
+    }
+
+    static size_t read_length(unsigned char const *& in,
+        unsigned char const * end, size_t length)
+    {
+        if(length != 15)
+            return length;
+
+        for(;;)
+        {
+            if(in == end)
+                corrupt();
+            unsigned char b = *in++;
+            length += b;
+            if(b != 255)
+                return length;
+        }
+    }
+
+    [[noreturn]] static void corrupt()
+    { throw std::logic_error("corrupt compressed frame"); }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __SNAPSHOT_MAPPING_HPP__
+#define __SNAPSHOT_MAPPING_HPP__
+
+#include "saveable_coroutine.hpp"
+
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * A snapshot file mapped copy-on-write into memory.
+ *
+ * Coroutines restored from the mapping with load_coro_in_place run right
+ * inside the mapped pages.  Only the pages they write to are copied and 
+ * the file itself is never modified.  The mapping must outlive every 
+ * coroutine restored from it, and each snapshot in it can be restored only
+ * once; map the file again to restore it again.
+ */
+class mapped_snapshot
+{
+public:
+    // populate pre-faults the whole file instead of faulting pages in as 
+    // the restored frames are touched
+    explicit mapped_snapshot(std::string const & path, bool populate = false) :
+        m_data{nullptr}, m_size{0}
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+            throw std::system_error(errno, std::generic_category(), path);
+
+        struct stat st;
+        if(::fstat(fd, &st) < 0)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+
+        m_size = st.st_size;
+        if(m_size > 0)
+        {
+            void * data = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, 
+                MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+            if(data == MAP_FAILED)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), path);
+            }
+            m_data = static_cast<char*>(data);
+        }
+
+        // the mapping stays valid without the descriptor
+        ::close(fd);
+    }
+
+    mapped_snapshot(mapped_snapshot && other) noexcept :
+        m_data{std::exchange(other.m_data, nullptr)}, 
+        m_size{std::exchange(other.m_size, 0)}
+    { }
+
+    mapped_snapshot & operator=(mapped_snapshot && other) noexcept
+    {
+        if(this == &other)
+            return *this;
+        unmap();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    mapped_snapshot(mapped_snapshot const &) = delete;
+    mapped_snapshot & operator=(mapped_snapshot const &) = delete;
+
+    ~mapped_snapshot() 
+    { unmap(); }
+
+    std::span<char> data() 
+    { return {m_data, m_size}; }
+
+    size_t size() const 
+    { return m_size; }
+
+private:
+    void unmap()
+    {
+        if(m_data != nullptr)
+            ::munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    char * m_data;
+    size_t m_size;
+};
+
+// restores the coroutine whose snapshot starts at offset in the mapping
+template<typename HandleType, typename... ArgTypes>
+saveable<HandleType> load_coro(mapped_snapshot & snapshot, size_t offset,
+    ArgTypes &... args)
+{
+    if(offset > snapshot.size())
+        throw std::logic_error("truncated snapshot");
+
+    return load_coro_in_place<HandleType>(snapshot.data().subspan(offset), 
+        args...);
+}
+
+#endif
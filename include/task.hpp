@@ -1,6 +1,8 @@
 #ifndef __TASK_H__
 #define __TASK_H__
 
+#include "promise_allocator.hpp"
+
 #include <coroutine>
 #include <variant>
 #include <stdexcept>
@@ -10,7 +12,7 @@ class task {
 public:
     struct awaiter;
 
-    class promise_type {
+    class promise_type : public allocator_aware_promise<> {
     public:
         promise_type() noexcept;
         ~promise_type();
@@ -74,7 +76,7 @@ class task<void> {
 public:
     struct awaiter;
 
-    class promise_type {
+    class promise_type : public allocator_aware_promise<> {
     public:
         promise_type() noexcept : continuation_{}, result_{} {}
         ~promise_type() {}
@@ -117,11 +119,17 @@ public:
 
     task(task&& t) noexcept : coro_{t.coro_}
     { t.coro_ = nullptr; }
-    ~task() { coro_.destroy(); }
+    ~task() 
+    { 
+        if(coro_)
+            coro_.destroy(); 
+    }
     task& operator=(task&& t) noexcept
     { 
         if(this == &t)
             return *this;
+        if(coro_)
+            coro_.destroy();
         coro_ = t.coro_;
         t.coro_ = nullptr;
         return *this;
@@ -136,9 +144,9 @@ public:
     struct awaiter {
         explicit awaiter(std::coroutine_handle<promise_type> h) noexcept :
             coro_{h} { }
+        // a void task that finished normally still holds monostate
         bool await_ready() noexcept
-        { return !std::holds_alternative<std::monostate>(
-            coro_.promise().result_); }
+        { return coro_.done(); }
         std::coroutine_handle<promise_type> await_suspend(
             std::coroutine_handle<> h) noexcept
         { 
@@ -233,15 +241,21 @@ task<T>& task<T>::operator=(task<T>&& t) noexcept
 { 
     if(this == &t)
         return *this;
+    if(coro_)
+        coro_.destroy();
     coro_ = std::move(t.coro_);
     t.coro_ = nullptr;
     return *this;
 }
 
-// if the task is destoyed then also destroy the coroutine
+// if the task is destoyed then also destroy the coroutine, moved from
+// tasks have none
 template<typename T>
 task<T>::~task()
-{ coro_.destroy(); }
+{ 
+    if(coro_)
+        coro_.destroy(); 
+}
 
 
 /***
@@ -0,0 +1,408 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include "frame_allocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * A unit of work for work_stealing_pool.
+ *
+ * Work items are intrusive: whoever posts one owns its storage and keeps it
+ * alive until run has been called, so posting never allocates.  run is
+ * called exactly once, on one of the pool's threads.
+ */
+struct pool_work
+{
+    void (*m_run)(pool_work *);
+    pool_work * m_next; // used by the pool while the work is queued
+
+    explicit pool_work(void (*run)(pool_work *)) :
+        m_run{run}, m_next{nullptr}
+    { }
+};
+
+/**
+ * Chase-Lev work-stealing deque
+ *
+ * The owning thread pushes and pops at the bottom, any other thread steals
+ * from the top.  The ring grows when full; outgrown rings are kept until
+ * the deque is destroyed since a thief may still be reading one.
+ *
+ * (Lê, Pop, Cohen, Zappa Nardelli, "Correct and Efficient Work-Stealing
+ * for Weak Memory Models", PPoPP 2013)
+ */
+template<typename T>
+class chase_lev_deque
+{
+public:
+    explicit chase_lev_deque(size_t capacity = 256) :
+        m_top{0}, m_bottom{0}, m_ring{nullptr}
+    {
+        m_rings.push_back(new ring(capacity));
+        m_ring.store(m_rings.back(), std::memory_order_relaxed);
+    }
+
+    chase_lev_deque(chase_lev_deque const &) = delete;
+    chase_lev_deque & operator=(chase_lev_deque const &) = delete;
+
+    ~chase_lev_deque()
+    {
+        for(ring * r : m_rings)
+            delete r;
+    }
+
+    // owner only
+    void push(T value)
+    {
+        std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+        std::int64_t t = m_top.load(std::memory_order_acquire);
+        ring * r = m_ring.load(std::memory_order_relaxed);
+
+        if(b - t > (std::int64_t)r->m_capacity - 1)
+            r = grow(r, t, b);
+
+        // a release store rather than the paper's fence, the same on x86
+        // and understood by thread sanitizer
+        r->put(b, value);
+        m_bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only, returns nullptr when empty
+    T pop()
+    {
+        std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        ring * r = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = m_top.load(std::memory_order_relaxed);
+
+        if(t > b)
+        {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T value = r->get(b);
+        if(t == b)
+        {
+            // the last item, race the thieves for it
+            if(!m_top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+                value = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // any thread, returns nullptr when empty or when it lost a race
+    T steal()
+    {
+        std::int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = m_bottom.load(std::memory_order_acquire);
+
+        if(t >= b)
+            return nullptr;
+
+        ring * r = m_ring.load(std::memory_order_acquire);
+        T value = r->get(t);
+        if(!m_top.compare_exchange_strong(t, t + 1,
+            std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return value;
+    }
+
+    bool empty() const
+    {
+        std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+        std::int64_t t = m_top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+private:
+    struct ring
+    {
+        explicit ring(size_t capacity) :
+            m_capacity{capacity}, m_items(new std::atomic<T>[capacity])
+        { }
+
+        ~ring()
+        { delete [] m_items; }
+
+        T get(std::int64_t i) const
+        { return m_items[i & (m_capacity - 1)].load(std::memory_order_relaxed); }
+
+        void put(std::int64_t i, T value)
+        { m_items[i & (m_capacity - 1)].store(value, std::memory_order_relaxed); }
+
+        size_t m_capacity; // a power of two
+        std::atomic<T> * m_items;
+    };
+
+    ring * grow(ring * r, std::int64_t t, std::int64_t b)
+    {
+        ring * bigger = new ring(2 * r->m_capacity);
+        for(std::int64_t i = t; i < b; ++i)
+            bigger->put(i, r->get(i));
+
+        m_rings.push_back(bigger);
+        m_ring.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    alignas(64) std::atomic<std::int64_t> m_top;
+    alignas(64) std::atomic<std::int64_t> m_bottom;
+    std::atomic<ring *> m_ring;
+    std::vector<ring *> m_rings; // owner only
+};
+
+/**
+ * Work-stealing thread pool
+ *
+ * Every worker owns a chase_lev_deque.  Work posted from a worker goes to
+ * the bottom of its own deque, work posted from any other thread goes to a
+ * shared injection queue.  A worker runs its own work newest first, then
+ * takes from the injection queue and finally steals the oldest work of the
+ * other workers.
+ *
+ * Workers that find nothing park.  Posting wakes a single parked worker
+ * and only when there is one, so a busy pool never touches the park mutex.
+ */
+class work_stealing_pool
+{
+public:
+    explicit work_stealing_pool(size_t thread_count =
+        std::thread::hardware_concurrency()) :
+        m_workers(std::max<size_t>(1, thread_count)),
+        m_injected{nullptr}, m_injected_tail{nullptr},
+        m_idle{0}, m_wakeups{0}, m_stopping{false}
+    {
+        m_threads.reserve(m_workers.size());
+        for(size_t id = 0; id < m_workers.size(); ++id)
+            m_threads.emplace_back(&work_stealing_pool::worker, this, id);
+    }
+
+    work_stealing_pool(work_stealing_pool const &) = delete;
+    work_stealing_pool & operator=(work_stealing_pool const &) = delete;
+
+    // runs all posted work before the workers exit
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard lock(m_park_mutex);
+            m_stopping.store(true, std::memory_order_seq_cst);
+        }
+        m_park.notify_all();
+        m_threads.clear();
+    }
+
+    size_t size() const
+    { return m_workers.size(); }
+
+    // queues work, which must stay alive until it has run
+    void post(pool_work & work)
+    {
+        if(t_worker.m_pool == this)
+            m_workers[t_worker.m_id].m_deque.push(&work);
+        else
+        {
+            std::lock_guard lock(m_inject_mutex);
+            if(m_injected_tail == nullptr)
+                m_injected = &work;
+            else
+                m_injected_tail->m_next = &work;
+            m_injected_tail = &work;
+            m_injected_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(m_idle.load(std::memory_order_relaxed) > 0)
+            wake_one();
+    }
+
+    // queues a copy of fn, its storage comes from the pooled frame
+    // allocator so steady state submission does not hit the heap
+    template<typename Fn>
+    void submit(Fn && fn)
+    {
+        using closure_type = closure<std::decay_t<Fn>>;
+
+        void * mem = pooled_frame_allocator<>::allocate(sizeof(closure_type));
+        post(*new(mem) closure_type(std::forward<Fn>(fn)));
+    }
+
+    // true on one of this pool's workers
+    bool running_in_pool() const
+    { return t_worker.m_pool == this; }
+
+private:
+    template<typename Fn>
+    struct closure : pool_work
+    {
+        explicit closure(Fn && fn) :
+            pool_work{&closure::run}, m_fn{std::move(fn)} { }
+        explicit closure(Fn const & fn) :
+            pool_work{&closure::run}, m_fn{fn} { }
+
+        static void run(pool_work * work)
+        {
+            closure * self = static_cast<closure*>(work);
+            struct release {
+                closure * m_self;
+                ~release() {
+                    m_self->~closure();
+                    pooled_frame_allocator<>::deallocate(m_self,
+                        sizeof(closure));
+                }
+            } guard{self};
+
+            self->m_fn();
+        }
+
+        Fn m_fn;
+    };
+
+    struct alignas(64) worker_state
+    {
+        chase_lev_deque<pool_work *> m_deque;
+    };
+
+    struct current_worker
+    {
+        work_stealing_pool * m_pool;
+        size_t m_id;
+    };
+
+    static inline thread_local current_worker t_worker = {nullptr, 0};
+
+    pool_work * take_injected()
+    {
+        if(m_injected_count.load(std::memory_order_relaxed) == 0)
+            return nullptr;
+
+        std::lock_guard lock(m_inject_mutex);
+        pool_work * work = m_injected;
+        if(work == nullptr)
+            return nullptr;
+
+        m_injected = work->m_next;
+        if(m_injected == nullptr)
+            m_injected_tail = nullptr;
+        work->m_next = nullptr;
+        m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+        return work;
+    }
+
+    pool_work * find_work(size_t id)
+    {
+        if(pool_work * work = m_workers[id].m_deque.pop())
+            return work;
+
+        if(pool_work * work = take_injected())
+            return work;
+
+        // steal round robin starting at the next worker
+        for(size_t i = 1; i < m_workers.size(); ++i)
+        {
+            auto & victim = m_workers[(id + i) % m_workers.size()];
+            if(pool_work * work = victim.m_deque.steal())
+                return work;
+        }
+
+        return nullptr;
+    }
+
+    bool work_visible() const
+    {
+        if(m_injected_count.load(std::memory_order_relaxed) > 0)
+            return true;
+        for(auto const & w : m_workers)
+            if(!w.m_deque.empty())
+                return true;
+        return false;
+    }
+
+    void wake_one()
+    {
+        {
+            std::lock_guard lock(m_park_mutex);
+            if(m_wakeups >= m_idle.load(std::memory_order_relaxed))
+                return;
+            ++m_wakeups;
+        }
+        m_park.notify_one();
+    }
+
+    // waits for a wake up, returns false once the pool stops and no work
+    // is left
+    bool park()
+    {
+        m_idle.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // work posted before the increment was seen is found here, work
+        // posted after it sees an idle worker and wakes it
+        if(work_visible())
+        {
+            m_idle.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        std::unique_lock lock(m_park_mutex);
+        m_park.wait(lock, [this]{
+            return m_wakeups > 0 || m_stopping.load();
+        });
+
+        if(m_wakeups > 0)
+            --m_wakeups;
+        m_idle.fetch_sub(1, std::memory_order_relaxed);
+
+        return !m_stopping.load() || work_visible();
+    }
+
+    void worker(size_t id)
+    {
+        t_worker = {this, id};
+
+        for(;;)
+        {
+            if(pool_work * work = find_work(id))
+            {
+                work->m_run(work);
+                continue;
+            }
+
+            if(!park())
+                break;
+        }
+
+        t_worker = {nullptr, 0};
+    }
+
+    std::vector<worker_state> m_workers;
+
+    std::mutex m_inject_mutex;
+    pool_work * m_injected;
+    pool_work * m_injected_tail;
+    std::atomic<size_t> m_injected_count{0};
+
+    std::atomic<size_t> m_idle;
+    std::mutex m_park_mutex;
+    std::condition_variable m_park;
+    size_t m_wakeups;               // under m_park_mutex
+    std::atomic<bool> m_stopping;
+
+    std::vector<std::jthread> m_threads;
+};
+
+#endif
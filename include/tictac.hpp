@@ -3,9 +3,11 @@
 
 #include "ranges.hpp"
 #include "game.hpp"
+#include "zobrist.hpp"
 
 #include <iostream>
 #include <array>
+#include <cstdint>
 
 class TicTac { 
 public:
@@ -61,6 +63,7 @@ public:
 
         return Blank; 
     }
+    // HACK: writing through at() does not update hash(), use play
     Mark& at(Move m)             { return m_board[(unsigned)m]; }
     Mark const& at(Move m) const { return m_board[(unsigned)m]; }
 
@@ -78,12 +81,20 @@ public:
 
     bool done() const
     { return winner() != Blank; }
+    // a finished game was either drawn or won by the last move
+    int score() const
+    { return winner() == Cats ? 0 : -1; }
+    // Zobrist key of the board, kept up to date by play
+    std::uint64_t hash() const
+    { return m_hash; }
     bool play(Move m)
     {
         if(at(m) != Blank)
             return false;
     
-        at(m) = turn();
+        Mark mark = turn();
+        at(m) = mark;
+        m_hash ^= keys::key((unsigned)m, mark - X);
         return true;
     }
 
@@ -116,9 +127,15 @@ public:
         return ret;
     }
 
-    TicTac() : m_board{Blank} { }
+    TicTac() : m_board{Blank}, m_hash{0} { }
 
     std::array<Mark, TotalMoves> m_board;
+
+private:
+    // an X or an O on each square, the side to move follows from the board
+    using keys = zobrist_keys<TotalMoves, 2>;
+
+    std::uint64_t m_hash;
 };
 
 TicTac::Move & operator++(TicTac::Move & move) 
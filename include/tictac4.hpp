@@ -0,0 +1,230 @@
+#ifndef __TICTAC4_HPP__
+#define __TICTAC4_HPP__
+
+#include "ranges.hpp"
+#include "game.hpp"
+#include "zobrist.hpp"
+
+#include <iostream>
+#include <array>
+#include <cstdint>
+
+// tic-tac-toe on a 4x4 board, four in a row wins.  big enough that a full
+// search takes a while, small enough to finish from the middle game
+class TicTac4 {
+public:
+    enum Mark { 
+        Blank = 0,
+        X = 1,
+        O = 2,
+        Cats = 3,
+    };
+
+    // square 4 * row + column
+    enum Move {
+        TopLeft = 0, BottomRight = 15,
+        TotalMoves = 16,
+    };
+
+    static Move square(int r, int c)
+    { return (Move)(4 * r + c); }
+
+    Mark turn() const
+    { 
+        if(m_moves == TotalMoves)
+            return Blank;
+        return m_moves % 2 == 1 ? O : X;
+    }
+    // kept by play, only the last move can have won
+    Mark winner() const
+    { return m_winner; }
+
+    Mark const& at(Move m) const { return m_board[(unsigned)m]; }
+    Mark const& at(int r, int c) const { return m_board[4 * r + c]; }
+
+    // standard game interface
+    auto operator()(Move m) { return play(m); }
+    operator bool() const   { return !done(); }
+    // used for storing state in sorted containers
+    bool operator==(TicTac4 const& other) const 
+    { return m_board == other.m_board; }
+    bool operator<(TicTac4 const& other) const
+    { return m_board < other.m_board; }
+
+    bool done() const
+    { return winner() != Blank; }
+    // a finished game was either drawn or won by the last move
+    int score() const
+    { return winner() == Cats ? 0 : -1; }
+    // lines still open to only one player, worth more the fuller they
+    // are, counted for the player to move and against the other
+    int evaluate() const
+    {
+        static constexpr int s_weights[] = {0, 1, 4, 32, 0};
+
+        Mark me = turn();
+        int score = 0;
+        for(int l = 0; l < 10; ++l)
+        {
+            int mine = 0, theirs = 0;
+            for(int i = 0; i < 4; ++i)
+            {
+                Mark m = at(line_square(l, i));
+                mine += m == me;
+                theirs += m != Blank && m != me;
+            }
+
+            if(theirs == 0)
+                score += s_weights[mine];
+            else if(mine == 0)
+                score -= s_weights[theirs];
+        }
+        return score;
+    }
+    // Zobrist key of the board, kept up to date by play
+    std::uint64_t hash() const
+    { return m_hash; }
+    bool play(Move m)
+    {
+        if(done() || at(m) != Blank)
+            return false;
+    
+        Mark mark = turn();
+        m_board[(unsigned)m] = mark;
+        m_hash ^= keys::key((unsigned)m, mark - X);
+        ++m_moves;
+
+        if(completes_line(m, mark))
+            m_winner = mark;
+        else if(m_moves == TotalMoves)
+            m_winner = Cats;
+        return true;
+    }
+
+    using action_type = Move;
+
+    Ranges<action_type> actions() const
+    { 
+        Ranges<action_type> ret;
+
+        if(done())
+            return ret;
+
+        int range_start = -1; // not started
+        for(int m = 0; m < TotalMoves; m++)
+        {
+            if(at((Move)m) != Blank)
+            {
+                if(range_start >= 0)
+                    ret.insert((Move)range_start, (Move)m);
+                range_start = -1;
+                continue;
+            }
+            
+            if(range_start < 0)
+                range_start = m;
+        }
+        if(range_start >= 0)
+            ret.insert((Move)range_start, TotalMoves);
+
+        return ret;
+    }
+
+    TicTac4() : m_board{Blank}, m_moves{0}, m_winner{Blank}, m_hash{0} { }
+
+private:
+    // the i-th square of line l: 4 rows, 4 columns, then both diagonals
+    static Move line_square(int l, int i)
+    {
+        if(l < 4)
+            return square(l, i);
+        if(l < 8)
+            return square(i, l - 4);
+        return l == 8 ? square(i, i) : square(i, 3 - i);
+    }
+
+    bool completes_line(Move m, Mark mark) const
+    {
+        int r = m / 4, c = m % 4;
+        bool row = true, column = true, diagonal = r == c, 
+             anti = r + c == 3;
+        for(int i = 0; i < 4; ++i)
+        {
+            row = row && at(r, i) == mark;
+            column = column && at(i, c) == mark;
+            diagonal = diagonal && at(i, i) == mark;
+            anti = anti && at(i, 3 - i) == mark;
+        }
+        return row || column || diagonal || anti;
+    }
+
+    // an X or an O on each square, the side to move follows from the board
+    using keys = zobrist_keys<TotalMoves, 2>;
+
+    std::array<Mark, TotalMoves> m_board;
+    int m_moves;
+    Mark m_winner;
+    std::uint64_t m_hash;
+};
+
+inline TicTac4::Move & operator++(TicTac4::Move & move) 
+{ 
+    move = static_cast<TicTac4::Move>((int)move + 1);
+    return move; 
+}
+
+inline std::ostream& operator<<(std::ostream& os, 
+    TicTac4::action_type const& act)
+{
+    int m = (int)act;
+    os << m / 4 << " " << m % 4;
+    return os;
+}
+
+inline std::istream& operator>>(std::istream& is, TicTac4::action_type& act)
+{
+    int r, c;
+    is >> r >> c;
+    act = TicTac4::square(r, c);
+    return is;
+}
+
+inline std::ostream& operator<<(std::ostream& os, TicTac4::Mark mark)
+{
+    char c;
+
+    switch(mark) {
+    case TicTac4::X: c = 'X'; break;
+    case TicTac4::O: c = 'O'; break;
+    case TicTac4::Cats: c = 'C'; break;
+    case TicTac4::Blank: 
+    default: 
+        c = ' ';
+        break;
+    }
+
+    return os << c; 
+}
+
+inline std::ostream& operator<<(std::ostream& os, TicTac4 const& board)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            os << board.at(i, j);
+            if(j < 3) 
+                os << "|";
+        }
+
+        if(i < 3)
+            os << "\n-------";
+
+        os << "\n";
+    }
+    os << "turn: " << board.turn() << "\n";
+
+    return os;
+}
+
+#endif
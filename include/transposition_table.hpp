@@ -0,0 +1,210 @@
+#ifndef __TRANSPOSITION_TABLE_HPP__
+#define __TRANSPOSITION_TABLE_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+using std::size_t;
+
+/**
+ * Transposition table
+ *
+ * A fixed-size cache of search results keyed by a 64-bit state hash.
+ * Entries are 16 bytes, four to a 64-byte bucket, and a key can only
+ * live in the bucket its low bits select, so a probe touches one cache
+ * line.  The table never grows past the memory it was given.
+ *
+ * An entry is one packed word
+ *
+ *     | score : 32 | move : 16 | depth : 8 | bound : 2 | generation : 6 |
+ *
+ * so actions must be enums or integers that fit in 16 bits, and the key
+ * XORed with it.  The table can be shared by searches on several threads
+ * without locks: both words are relaxed atomics, and an entry torn by two
+ * stores at once no longer XORs back to its key so a probe takes it for
+ * a miss.  Which store wins does not matter, either is a correct result.
+ *
+ * When a bucket is full the entry worth the least is replaced, that is
+ * the shallowest one, with entries from earlier searches counting as 4
+ * plies shallower for every search since.
+ */
+enum class bound : std::uint8_t
+{
+    none = 0,
+    exact = 1,
+    lower = 2, // the score is at least this, a beta cutoff
+    upper = 3, // the score is at most this, nothing beat alpha
+};
+
+template<typename Action>
+class transposition_table
+{
+    static_assert(std::is_enum_v<Action> || std::is_integral_v<Action>,
+        "transposition_table packs actions into 16 bits");
+
+public:
+    static constexpr int max_depth = 255;
+
+    struct entry_value
+    {
+        int m_score;
+        int m_depth;
+        bound m_bound;
+        std::optional<Action> m_move;
+    };
+
+    // counted by each search rather than the table, so threads sharing
+    // it do not fight over the counters
+    struct statistics
+    {
+        size_t m_probes = 0;
+        size_t m_hits = 0;
+        size_t m_stores = 0;
+
+        double hit_rate() const
+        { return m_probes > 0 ? (double)m_hits / m_probes : 0; }
+    };
+
+    // uses at most bytes of memory, at least one bucket
+    explicit transposition_table(size_t bytes) :
+        m_buckets{}, m_mask{0}, m_generation{0}
+    {
+        size_t count = std::bit_floor(
+            std::max<size_t>(1, bytes / sizeof(bucket)));
+        m_buckets = std::make_unique<bucket[]>(count);
+        m_mask = count - 1;
+    }
+
+    std::optional<entry_value> probe(std::uint64_t key) const
+    {
+        for(entry const& e : m_buckets[key & m_mask].m_entries)
+        {
+            std::uint64_t data = e.m_data.load(std::memory_order_relaxed);
+            if(data != 0 &&
+               (e.m_check.load(std::memory_order_relaxed) ^ data) == key)
+                return unpack(data);
+        }
+
+        return std::nullopt;
+    }
+
+    void store(std::uint64_t key, int score, int depth, bound b,
+        std::optional<Action> move)
+    {
+        if(b == bound::none)
+            return;
+
+        bucket & bk = m_buckets[key & m_mask];
+        entry * victim = &bk.m_entries[0];
+        std::uint64_t victim_data = 0;
+        int victim_worth = max_depth + 1;
+
+        for(entry & e : bk.m_entries)
+        {
+            std::uint64_t data = e.m_data.load(std::memory_order_relaxed);
+            if(data == 0 ||
+               (e.m_check.load(std::memory_order_relaxed) ^ data) == key)
+            {
+                victim = &e;
+                victim_data = data;
+                break;
+            }
+
+            int worth = worth_of(data);
+            if(worth < victim_worth)
+            {
+                victim = &e;
+                victim_data = 0;
+                victim_worth = worth;
+            }
+        }
+
+        // keep the best move of an earlier search of the same state
+        if(!move && victim_data != 0)
+            move = unpack(victim_data).m_move;
+
+        std::uint64_t data = pack(score, depth, b, move);
+        victim->m_check.store(key ^ data, std::memory_order_relaxed);
+        victim->m_data.store(data, std::memory_order_relaxed);
+    }
+
+    // ages every entry, call before each search and never during one
+    void new_search()
+    { m_generation = (m_generation + 1) & generation_mask; }
+
+    // only while nothing searches
+    void clear()
+    {
+        for(size_t i = 0; i <= m_mask; ++i)
+            for(entry & e : m_buckets[i].m_entries)
+            {
+                e.m_check.store(0, std::memory_order_relaxed);
+                e.m_data.store(0, std::memory_order_relaxed);
+            }
+    }
+
+    size_t capacity() const
+    { return (m_mask + 1) * entries_per_bucket; }
+
+    size_t memory() const
+    { return (m_mask + 1) * sizeof(bucket); }
+
+private:
+    static constexpr size_t entries_per_bucket = 4;
+    static constexpr std::uint64_t generation_mask = 0x3f;
+
+    struct entry
+    {
+        std::atomic<std::uint64_t> m_check{0}; // key ^ data
+        std::atomic<std::uint64_t> m_data{0};  // 0 when empty
+    };
+
+    struct alignas(64) bucket
+    {
+        entry m_entries[entries_per_bucket];
+    };
+
+    static_assert(sizeof(bucket) == 64, "a bucket is one cache line");
+
+    // the move field holds action + 1, 0 is no move
+    std::uint64_t pack(int score, int depth, bound b,
+        std::optional<Action> move) const
+    {
+        std::uint64_t m = move ? ((std::uint64_t)*move + 1) & 0xffff : 0;
+        std::uint64_t d = (std::uint64_t)std::clamp(depth, 0, max_depth);
+
+        return (std::uint64_t)(std::uint32_t)score << 32 | m << 16 |
+            d << 8 | (std::uint64_t)b << 6 | m_generation;
+    }
+
+    static entry_value unpack(std::uint64_t data)
+    {
+        std::uint64_t m = (data >> 16) & 0xffff;
+        return {
+            .m_score = (int)(std::int32_t)(std::uint32_t)(data >> 32),
+            .m_depth = (int)((data >> 8) & 0xff),
+            .m_bound = (bound)((data >> 6) & 0x3),
+            .m_move = m ? std::optional<Action>{(Action)(m - 1)}
+                        : std::nullopt,
+        };
+    }
+
+    int worth_of(std::uint64_t data) const
+    {
+        int depth = (int)((data >> 8) & 0xff);
+        int age = (int)((m_generation - data) & generation_mask);
+        return depth - 4 * age;
+    }
+
+    std::unique_ptr<bucket[]> m_buckets;
+    size_t m_mask;
+    std::uint64_t m_generation;
+};
+
+#endif
@@ -0,0 +1,548 @@
+#ifndef __WHEN_ALL_HPP__
+#define __WHEN_ALL_HPP__
+
+#include "task.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * when_all / when_any
+ *
+ *     auto [a, b] = co_await when_all(sched, f(), g());
+ *     co_await when_all(sched, std::move(tasks));
+ *     auto first = co_await when_any(sched, std::move(tasks));
+ *
+ * A range of tasks is moved from, so it has to be handed over as an rvalue
+ * container or yield rvalues, e.g. tasks | std::views::as_rvalue.  An
+ * lvalue container is rejected rather than emptied behind the caller's
+ * back.
+ *
+ * Every task is wrapped in a child coroutine.  With a scheduler the
+ * children are posted to its pool all at once, without one they are
+ * started in turn on the awaiting thread and run until they first suspend.
+ * The awaiting coroutine suspends once and is resumed exactly once, by
+ * whoever finishes last, through symmetric transfer.
+ *
+ * void tasks yield std::monostate in a when_all tuple.
+ */
+template<typename T>
+using when_all_value_t =
+    std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+// counts down the children of a when_all plus the awaiting coroutine,
+// whoever arrives last continues the awaiting coroutine
+class when_all_latch
+{
+public:
+    explicit when_all_latch(size_t children) :
+        m_count{children + 1}, m_parent{}
+    { }
+
+    // the awaiting coroutine, true if it has to wait for the children
+    bool suspend(std::coroutine_handle<> parent) noexcept
+    {
+        m_parent = parent;
+        return m_count.fetch_sub(1, std::memory_order_acq_rel) > 1;
+    }
+
+    // a finished child, returns the coroutine to continue with
+    std::coroutine_handle<> arrive() noexcept
+    {
+        if(m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            return m_parent;
+        return std::noop_coroutine();
+    }
+
+private:
+    std::atomic<size_t> m_count;
+    std::coroutine_handle<> m_parent;
+};
+
+// the promise of a child is its own pool work item so posting it to a pool
+// allocates nothing
+struct when_child_promise : pool_work
+{
+    when_child_promise() : pool_work{&when_child_promise::run}, m_self{} { }
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+
+    // starts the child on sched, or right here without one
+    void start(std::optional<scheduler> const & sched)
+    {
+        if(sched)
+            sched->pool().post(*this);
+        else
+            m_self.resume();
+    }
+
+protected:
+    std::coroutine_handle<> m_self; // set by get_return_object
+
+private:
+    static void run(pool_work * work)
+    { static_cast<when_child_promise*>(work)->m_self.resume(); }
+};
+
+template<typename T>
+struct when_child_result
+{
+    std::variant<std::monostate, when_all_value_t<T>, std::exception_ptr>
+        m_result;
+
+    void return_value(T && value)
+    { m_result.template emplace<1>(std::move(value)); }
+
+    void unhandled_exception() noexcept
+    { m_result.template emplace<2>(std::current_exception()); }
+
+    when_all_value_t<T> get()
+    {
+        if(m_result.index() == 2)
+            std::rethrow_exception(std::get<2>(m_result));
+        return std::move(std::get<1>(m_result));
+    }
+};
+
+template<>
+struct when_child_result<void>
+{
+    std::variant<std::monostate, std::monostate, std::exception_ptr>
+        m_result;
+
+    void return_void()
+    { m_result.emplace<1>(); }
+
+    void unhandled_exception() noexcept
+    { m_result.emplace<2>(std::current_exception()); }
+
+    std::monostate get()
+    {
+        if(m_result.index() == 2)
+            std::rethrow_exception(std::get<2>(m_result));
+        return {};
+    }
+};
+
+// a task wrapped for when_all, owned by the when_all
+template<typename T>
+class when_all_child
+{
+public:
+    struct promise_type : when_child_promise, when_child_result<T>
+    {
+        struct final_awaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) const noexcept
+            { return h.promise().m_latch->arrive(); }
+            void await_resume() const noexcept { }
+        };
+
+        when_all_child get_return_object() noexcept
+        {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            m_self = h;
+            return when_all_child{h};
+        }
+        final_awaiter final_suspend() const noexcept { return {}; }
+
+        using when_child_result<T>::unhandled_exception;
+
+        when_all_latch * m_latch = nullptr;
+    };
+
+    when_all_child(when_all_child && other) noexcept :
+        m_handle{std::exchange(other.m_handle, nullptr)}
+    { }
+
+    ~when_all_child()
+    {
+        if(m_handle)
+            m_handle.destroy();
+    }
+
+    void start(when_all_latch & latch, std::optional<scheduler> const & sched)
+    {
+        m_handle.promise().m_latch = &latch;
+        m_handle.promise().start(sched);
+    }
+
+    when_all_value_t<T> result()
+    { return m_handle.promise().get(); }
+
+private:
+    explicit when_all_child(std::coroutine_handle<promise_type> handle) :
+        m_handle{handle}
+    { }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename T>
+when_all_child<T> make_when_all_child(task<T> t)
+{ co_return co_await std::move(t); }
+
+inline when_all_child<void> make_when_all_child(task<void> t)
+{ co_await std::move(t); }
+
+// starts the children once the awaiting coroutine is suspended
+template<typename Start>
+struct when_all_start
+{
+    when_all_latch & m_latch;
+    Start m_start;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> parent)
+    {
+        m_start();
+        return m_latch.suspend(parent);
+    }
+
+    void await_resume() const noexcept { }
+};
+
+template<typename... Ts>
+task<std::tuple<when_all_value_t<Ts>...>> when_all_on(
+    std::optional<scheduler> sched, task<Ts>... tasks)
+{
+    std::tuple<when_all_child<Ts>...> children{
+        make_when_all_child(std::move(tasks))...};
+    when_all_latch latch{sizeof...(Ts)};
+
+    auto start = [&]() {
+        std::apply([&](auto &... child) {
+            (child.start(latch, sched), ...);
+        }, children);
+    };
+    co_await when_all_start<decltype(start)>{latch, start};
+
+    // the first failure in argument order is rethrown
+    co_return std::apply([](auto &... child) {
+        return std::tuple<when_all_value_t<Ts>...>{child.result()...};
+    }, children);
+}
+
+template<typename T>
+std::vector<when_all_child<T>> make_when_all_children(
+    std::vector<task<T>> & tasks)
+{
+    std::vector<when_all_child<T>> children;
+    children.reserve(tasks.size());
+    for(auto & t : tasks)
+        children.push_back(make_when_all_child(std::move(t)));
+    return children;
+}
+
+template<typename T>
+task<std::vector<T>> when_all_on(std::optional<scheduler> sched,
+    std::vector<task<T>> tasks)
+{
+    auto children = make_when_all_children(tasks);
+    when_all_latch latch{children.size()};
+
+    auto start = [&]() {
+        for(auto & child : children)
+            child.start(latch, sched);
+    };
+    co_await when_all_start<decltype(start)>{latch, start};
+
+    std::vector<T> results;
+    results.reserve(children.size());
+    for(auto & child : children)
+        results.push_back(child.result());
+    co_return results;
+}
+
+inline task<void> when_all_on(std::optional<scheduler> sched,
+    std::vector<task<void>> tasks)
+{
+    auto children = make_when_all_children(tasks);
+    when_all_latch latch{children.size()};
+
+    auto start = [&]() {
+        for(auto & child : children)
+            child.start(latch, sched);
+    };
+    co_await when_all_start<decltype(start)>{latch, start};
+
+    for(auto & child : children)
+        child.result();
+}
+
+template<typename T>
+struct is_task : std::false_type { };
+
+template<typename T>
+struct is_task<task<T>> : std::true_type { };
+
+// a range of tasks that may be moved from: a container passed as an
+// rvalue, or any range whose elements are not lvalues.  a view of lvalues
+// is refused as well, its tasks belong to someone else
+template<typename R>
+concept movable_task_range = std::ranges::input_range<R> &&
+    is_task<std::ranges::range_value_t<R>>::value &&
+    ((!std::is_lvalue_reference_v<R> &&
+      !std::ranges::view<std::remove_cvref_t<R>>) ||
+     !std::is_lvalue_reference_v<std::ranges::range_reference_t<R>>);
+
+// moves a range of tasks into a vector, a vector passed as an rvalue is
+// taken as is
+template<movable_task_range R>
+auto collect_tasks(R && tasks)
+{
+    using vector_type = std::vector<std::ranges::range_value_t<R>>;
+
+    if constexpr(std::is_same_v<R, vector_type>)
+        return vector_type{std::move(tasks)};
+    else
+    {
+        vector_type collected;
+        for(auto && t : tasks)
+            collected.push_back(std::move(t));
+        return collected;
+    }
+}
+
+// runs tasks concurrently, started on the awaiting thread
+template<typename... Ts>
+auto when_all(task<Ts>... tasks)
+{ return when_all_on(std::nullopt, std::move(tasks)...); }
+
+// runs tasks concurrently on sched
+template<typename... Ts>
+auto when_all(scheduler sched, task<Ts>... tasks)
+{ return when_all_on(sched, std::move(tasks)...); }
+
+// runs every task of a range concurrently, yields a vector of results or
+// nothing for void tasks
+template<movable_task_range R>
+auto when_all(R && tasks)
+{ return when_all_on(std::nullopt, collect_tasks(std::forward<R>(tasks))); }
+
+template<movable_task_range R>
+auto when_all(scheduler sched, R && tasks)
+{ return when_all_on(sched, collect_tasks(std::forward<R>(tasks))); }
+
+/**
+ * when_any resumes the awaiting coroutine as soon as the first task
+ * finishes and yields its index and result.  The other tasks keep running
+ * in the background, their results are dropped; their children share the
+ * when_any state so it outlives the awaiting coroutine.
+ */
+template<typename T>
+struct when_any_result
+{
+    size_t m_index;
+    when_all_value_t<T> m_value;
+};
+
+template<typename T>
+struct when_any_state
+{
+    std::atomic<bool> m_decided{false};
+    std::atomic<int> m_arrivals{0};
+    std::coroutine_handle<> m_parent;
+
+    size_t m_index = 0;
+    std::variant<std::monostate, when_all_value_t<T>, std::exception_ptr>
+        m_result;
+
+    // true for the first child to finish
+    bool decide() noexcept
+    { return !m_decided.exchange(true, std::memory_order_acq_rel); }
+
+    // the awaiting coroutine and the first child arrive, the second one to
+    // arrive continues the awaiting coroutine
+    bool arrive() noexcept
+    { return m_arrivals.fetch_add(1, std::memory_order_acq_rel) == 1; }
+};
+
+// a task wrapped for when_any, frees itself once it finished
+class when_any_child
+{
+public:
+    struct promise_type : when_child_promise
+    {
+        struct final_awaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(
+                std::coroutine_handle<promise_type> h) const noexcept
+            {
+                std::coroutine_handle<> next = h.promise().m_continuation;
+                h.destroy();
+                return next ? next : std::noop_coroutine();
+            }
+            void await_resume() const noexcept { }
+        };
+
+        when_any_child get_return_object() noexcept
+        {
+            auto h = std::coroutine_handle<promise_type>::from_promise(*this);
+            m_self = h;
+            return when_any_child{h};
+        }
+        final_awaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept { }
+        void unhandled_exception() const noexcept { std::terminate(); }
+
+        std::coroutine_handle<> m_continuation;
+    };
+
+    // the child owns itself from here on
+    void start(std::optional<scheduler> const & sched)
+    { std::exchange(m_handle, nullptr).promise().start(sched); }
+
+    when_any_child(when_any_child && other) noexcept :
+        m_handle{std::exchange(other.m_handle, nullptr)}
+    { }
+
+    ~when_any_child()
+    {
+        if(m_handle)
+            m_handle.destroy();
+    }
+
+private:
+    explicit when_any_child(std::coroutine_handle<promise_type> handle) :
+        m_handle{handle}
+    { }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// the coroutine_handle of the child coroutine currently running, its
+// promise is where a winning child leaves the awaiting coroutine
+struct when_any_self
+{
+    when_any_child::promise_type * m_promise;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(
+        std::coroutine_handle<when_any_child::promise_type> h) noexcept
+    {
+        m_promise = &h.promise();
+        return false;
+    }
+    when_any_child::promise_type & await_resume() const noexcept
+    { return *m_promise; }
+};
+
+template<typename T>
+when_any_child make_when_any_child(task<T> t,
+    std::shared_ptr<when_any_state<T>> state, size_t index)
+{
+    auto & self = co_await when_any_self{};
+
+    std::variant<std::monostate, when_all_value_t<T>, std::exception_ptr>
+        result;
+    try {
+        if constexpr(std::is_void_v<T>)
+        {
+            co_await std::move(t);
+            result.template emplace<1>();
+        }
+        else
+            result.template emplace<1>(co_await std::move(t));
+    } catch(...) {
+        result.template emplace<2>(std::current_exception());
+    }
+
+    if(state->decide())
+    {
+        state->m_index = index;
+        state->m_result = std::move(result);
+        if(state->arrive())
+            self.m_continuation = state->m_parent;
+    }
+}
+
+template<typename T>
+struct when_any_start
+{
+    when_any_state<T> & m_state;
+    std::vector<when_any_child> & m_children;
+    std::optional<scheduler> const & m_sched;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> parent)
+    {
+        m_state.m_parent = parent;
+        for(auto & child : m_children)
+            child.start(m_sched);
+        return !m_state.arrive();
+    }
+
+    void await_resume() const noexcept { }
+};
+
+template<typename T>
+task<when_any_result<T>> when_any_on(std::optional<scheduler> sched,
+    std::vector<task<T>> tasks)
+{
+    if(tasks.empty())
+        throw std::logic_error("when_any of no tasks");
+
+    auto state = std::make_shared<when_any_state<T>>();
+
+    std::vector<when_any_child> children;
+    children.reserve(tasks.size());
+    for(size_t i = 0; i < tasks.size(); ++i)
+        children.push_back(make_when_any_child(std::move(tasks[i]), state, i));
+
+    co_await when_any_start<T>{*state, children, sched};
+
+    if(state->m_result.index() == 2)
+        std::rethrow_exception(std::get<2>(state->m_result));
+
+    co_return when_any_result<T>{state->m_index,
+        std::move(std::get<1>(state->m_result))};
+}
+
+// yields the index and result of the first task of a range to finish
+template<movable_task_range R>
+auto when_any(R && tasks)
+{ return when_any_on(std::nullopt, collect_tasks(std::forward<R>(tasks))); }
+
+template<movable_task_range R>
+auto when_any(scheduler sched, R && tasks)
+{ return when_any_on(sched, collect_tasks(std::forward<R>(tasks))); }
+
+template<typename T, typename... Ts>
+    requires (std::is_same_v<T, Ts> && ...)
+auto when_any(task<T> first, task<Ts>... rest)
+{
+    std::vector<task<T>> tasks;
+    tasks.push_back(std::move(first));
+    (tasks.push_back(std::move(rest)), ...);
+    return when_any_on(std::nullopt, std::move(tasks));
+}
+
+template<typename T, typename... Ts>
+    requires (std::is_same_v<T, Ts> && ...)
+auto when_any(scheduler sched, task<T> first, task<Ts>... rest)
+{
+    std::vector<task<T>> tasks;
+    tasks.push_back(std::move(first));
+    (tasks.push_back(std::move(rest)), ...);
+    return when_any(sched, std::move(tasks));
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __ZOBRIST_HPP__
+#define __ZOBRIST_HPP__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+using std::size_t;
+
+/**
+ * Zobrist keys
+ *
+ * One random 64-bit key for every piece on every square, generated at
+ * compile time.  A state's hash is the XOR of the keys of the pieces on
+ * it, so putting a piece down or taking it away is a single XOR of its
+ * key and the hash is kept up to date by play() in O(1) instead of being
+ * computed again from the whole board.  The keys are random enough that
+ * any of their bits can index a table.
+ *
+ *     using keys = zobrist_keys<9, 2>;
+ *     m_hash ^= keys::key(square, piece);
+ *
+ * The same Seed always gives the same keys, so hashes can be compared
+ * between runs.
+ */
+template<size_t Squares, size_t Pieces, std::uint64_t Seed = 0x2545f4914f6cdd1d>
+struct zobrist_keys
+{
+    static constexpr size_t squares = Squares;
+    static constexpr size_t pieces = Pieces;
+
+    static constexpr std::uint64_t key(size_t square, size_t piece)
+    { return s_keys[square * Pieces + piece]; }
+
+private:
+    // splitmix64, one output per key
+    static constexpr std::array<std::uint64_t, Squares * Pieces> generate()
+    {
+        std::array<std::uint64_t, Squares * Pieces> keys{};
+        std::uint64_t state = Seed;
+        for(auto & k : keys)
+        {
+            std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            k = z ^ (z >> 31);
+        }
+        return keys;
+    }
+
+    static constexpr std::array<std::uint64_t, Squares * Pieces> s_keys =
+        generate();
+};
+
+#endif
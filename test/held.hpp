@@ -0,0 +1,95 @@
+#ifndef __HELD_HPP__
+#define __HELD_HPP__
+
+#include "saveable_coroutine.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * lazy coroutine which keeps its frame (and result) after returning
+ */
+template<typename T>
+struct held
+{
+    struct promise_type
+    {
+        std::suspend_always initial_suspend() { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        held get_return_object()
+        { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        void return_value(T value) { m_value = value; }
+        void unhandled_exception() { throw; }
+
+        T m_value{};
+    };
+
+    held(std::coroutine_handle<promise_type> handle) : m_handle{handle} { }
+
+    held & operator=(std::nullptr_t)
+    {
+        m_handle = nullptr;
+        return *this;
+    }
+
+    T get()
+    {
+        if(!m_handle.done())
+            m_handle.resume();
+        return m_handle.promise().m_value;
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// the frame most tests save and restore, restored with y it returns y + 1
+inline saveable<held<int>> add_one(int x)
+{ co_return x + 1; }
+
+// links n add_one frames into an await chain by hand
+inline saveable<held<int>> make_chain(size_t n, int & x)
+{
+    auto root = add_one(x);
+    frame_header * header = root.get_header();
+    for(size_t i = 1; i < n; ++i)
+    {
+        auto child = add_one(x);
+        header->child_address = child.address();
+        header = child.get_header();
+    }
+    return root;
+}
+
+// destroys every frame of an await chain linked by hand
+inline void destroy_chain(void * address)
+{
+    while(address != nullptr)
+    {
+        void * child =
+            saveable_promise<void>::header_from(address)->child_address;
+        std::coroutine_handle<>::from_address(address).destroy();
+        address = child;
+    }
+}
+
+// a copy of some bytes in memory aligned for frames, as restoring in place
+// needs
+struct aligned_copy
+{
+    explicit aligned_copy(std::string const & bytes) :
+        m_memory(bytes.size() / sizeof(std::max_align_t) + 1),
+        m_size{bytes.size()}
+    { std::memcpy(m_memory.data(), bytes.data(), bytes.size()); }
+
+    std::span<char> span()
+    { return {reinterpret_cast<char*>(m_memory.data()), m_size}; }
+
+    std::vector<std::max_align_t> m_memory;
+    size_t m_size;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "alpha_beta.hpp"
+
+#include <stdexcept>
+#include <iostream>
+
+using search_type = alpha_beta_search<TicTac>;
+
+// plain negamax over the whole tree, scored the same way
+int negamax(TicTac const & state, int ply)
+{
+    auto actions = state.actions();
+    if(actions.size() == 0)
+    {
+        int score = state.score();
+        return score > 0 ? search_type::win_score - ply
+             : score < 0 ? ply - search_type::win_score : 0;
+    }
+
+    int best = -search_type::infinity;
+    for(auto a = actions.value_begin(); a != actions.value_end(); ++a)
+    {
+        TicTac child = state;
+        child(*a);
+        best = std::max(best, -negamax(child, ply + 1));
+    }
+    return best;
+}
+
+int main(int ac, char * av[])
+{
+    search_type search;
+
+    // perfect play draws
+    auto opening = search.search(TicTac{});
+    if(opening.m_score != 0)
+        throw std::logic_error("error: tic-tac-toe should be a draw");
+
+    // agrees with plain negamax on a sample of positions, and its move
+    // reaches the score it reports
+    size_t checked = 0, i = 0;
+    for(auto const & state : game_tree(TicTac{}))
+    {
+        if(i++ % 211 != 0 || state.actions().size() == 0)
+            continue;
+
+        auto r = search.search(state);
+        if(r.m_score != negamax(state, 0))
+            throw std::logic_error("error: score differs from negamax");
+
+        TicTac child = state;
+        child(r.m_action);
+        if(-negamax(child, 1) != r.m_score)
+            throw std::logic_error("error: move does not reach the score");
+
+        ++checked;
+    }
+
+    // X to move wins at once at the top right instead of dragging it out
+    TicTac win;
+    for(auto m : {TicTac::TopLeft, TicTac::BottomLeft, TicTac::TopCenter,
+                  TicTac::BottomCenter})
+        win(m);
+    auto r = search.search(win);
+    if(r.m_action != TicTac::TopRight || 
+       r.m_score != search_type::win_score - 1)
+        throw std::logic_error("error: should win immediately");
+
+    // two perfect players draw
+    GameInterface<TicTac> game;
+    AlphaBetaInterface<TicTac> x, o;
+    game.add_player(x);
+    game.add_player(o);
+    TicTac final = turn_based(&game).get();
+    if(final.winner() != TicTac::Cats)
+        throw std::logic_error("error: perfect play should draw");
+
+    std::cout << checked << " positions checked, opening searched " 
+              << opening.m_nodes << " nodes" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "task.hpp"
+#include "async_generator.hpp"
+#include "scheduler.hpp"
+#include "thread_pool.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <iostream>
+#include <thread>
+
+task<int> square(int x)
+{ co_return x * x; }
+
+// awaits a task between yields and counts what it produced
+async_generator<int> squares(int n, int & produced)
+{
+    for(int i = 0; i < n; ++i)
+    {
+        int s = co_await square(i);
+        ++produced;
+        co_yield s;
+    }
+}
+
+async_generator<std::string> failing()
+{
+    co_yield std::string("first");
+    throw std::logic_error("producer failed");
+}
+
+// yields the same local twice and changes it between
+async_generator<std::string> named(std::string & after)
+{
+    std::string name = "first";
+    co_yield name;
+    co_yield name;
+    name += "!";
+    after = name;
+}
+
+task<std::string> take_named(std::string & after)
+{
+    auto gen = named(after);
+    std::string seen = *co_await gen;
+    seen += " " + *co_await gen;
+    co_await gen;
+    co_return seen;
+}
+
+// every element comes from a pool thread
+async_generator<std::thread::id> hops(scheduler sched, int n)
+{
+    for(int i = 0; i < n; ++i)
+    {
+        co_await sched.schedule();
+        co_yield std::this_thread::get_id();
+    }
+}
+
+task<int> sum_optional(int n, int & produced)
+{
+    auto gen = squares(n, produced);
+    int sum = 0;
+    while(std::optional<int> value = co_await gen)
+        sum += *value;
+    co_return sum;
+}
+
+task<int> sum_iterator(int n, int & produced)
+{
+    auto gen = squares(n, produced);
+    int sum = 0;
+    for(auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+        sum += *it;
+    co_return sum;
+}
+
+// takes two elements and leaves the rest
+task<int> take_two(int & produced)
+{
+    auto gen = squares(100, produced);
+    int a = *co_await gen;
+    int b = *co_await gen;
+    co_return a + b;
+}
+
+task<std::string> catch_failure()
+{
+    auto gen = failing();
+    std::string seen = *co_await gen.next();
+    try {
+        co_await gen.next();
+    } catch(std::logic_error const & e) {
+        seen += std::string(", ") + e.what();
+    }
+    co_return seen;
+}
+
+task<int> count_off_thread(scheduler sched, std::thread::id caller)
+{
+    int off = 0;
+    auto gen = hops(sched, 50);
+    for(auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+        off += *it != caller;
+    co_return off;
+}
+
+int main(int ac, char * av[])
+{
+    int produced = 0;
+    if(sum_optional(5, produced).get() != 30 || produced != 5)
+        throw std::logic_error("error: wrong sum through co_await");
+
+    produced = 0;
+    if(sum_iterator(5, produced).get() != 30 || produced != 5)
+        throw std::logic_error("error: wrong sum through the iterator");
+
+    // the producer never runs ahead of the consumer
+    produced = 0;
+    if(take_two(produced).get() != 1 || produced != 2)
+        throw std::logic_error("error: producer should stop after two");
+
+    if(catch_failure().get() != "first, producer failed")
+        throw std::logic_error("error: producer error should reach the "
+                               "consumer");
+
+    // a yielded lvalue is copied, the producer still has it
+    std::string after;
+    if(take_named(after).get() != "first first" || after != "first!")
+        throw std::logic_error("error: yielded lvalue should be copied");
+
+    work_stealing_pool pool(2);
+    scheduler sched(pool);
+    int off = sync_wait(count_off_thread(sched, std::this_thread::get_id()));
+    if(off != 50)
+        throw std::logic_error("error: elements should come from the pool");
+
+    std::cout << "async_generator ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "saveable_coroutine.hpp"
+#include "batch_restore.hpp"
+#include "held.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// runs every restored coroutine, the i-th was hydrated with i
+void check_results(std::vector<saveable<held<int>>> & restored,
+    std::string const & name)
+{
+    for(size_t i = 0; i < restored.size(); ++i)
+        if(restored[i].handle().get() != (int)i + 1)
+            throw std::logic_error("error: " + name + " restored coroutine " +
+                std::to_string(i) + " returned the wrong value");
+
+    for(auto & coroutine : restored)
+        coroutine.destroy();
+}
+
+template<typename Restore>
+bool rejected(Restore && restore)
+{
+    try {
+        auto restored = restore();
+        for(auto & coroutine : restored)
+            coroutine.destroy();
+    } catch(std::logic_error const &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int ac, char * av[])
+{
+    // several chunks so every thread gets some
+    constexpr size_t count = 300;
+    constexpr size_t threads = 4;
+
+    std::vector<std::string> snapshots;
+    std::string archive;
+    {
+        int x = 0;
+        std::vector<saveable<held<int>>> coroutines;
+        snapshot_archive_writer writer;
+        for(size_t i = 0; i < count; ++i)
+        {
+            coroutines.push_back(add_one(x));
+            writer.add(i, coroutines.back());
+
+            std::ostringstream os;
+            coroutines.back().save(os);
+            snapshots.push_back(os.str());
+        }
+
+        std::ostringstream os;
+        writer.write(os);
+        archive = os.str();
+
+        for(auto & coroutine : coroutines)
+            coroutine.destroy();
+    }
+
+    // every coroutine gets its own argument
+    std::vector<int> args(count);
+    for(size_t i = 0; i < count; ++i)
+        args[i] = (int)i;
+    auto args_for = [&args](size_t i) { return std::tie(args[i]); };
+
+    aligned_copy copied(archive);
+    snapshot_archive_view view(copied.span());
+    auto restored = restore_all<held<int>>(view, threads, args_for);
+    check_results(restored, "archive");
+
+    aligned_copy in_place(archive);
+    restored = restore_all_in_place<held<int>>(
+        snapshot_archive_view(in_place.span()), threads, args_for);
+    check_results(restored, "in place");
+
+    std::vector<std::istringstream> streams;
+    for(auto const & snapshot : snapshots)
+        streams.emplace_back(snapshot);
+    std::vector<std::istream*> stream_pointers;
+    for(auto & stream : streams)
+        stream_pointers.push_back(&stream);
+    restored = restore_all<held<int>>(
+        std::span<std::istream * const>{stream_pointers}, threads, args_for);
+    check_results(restored, "stream");
+
+    // one corrupt snapshot fails the batch, the rest is destroyed again
+    constexpr size_t version = offsetof(frame_header, version);
+    std::string corrupt = archive;
+    corrupt[view.entry(count / 2).offset + version] ^= 0x10;
+
+    aligned_copy bad(corrupt);
+    if(!rejected([&]{
+        return restore_all<held<int>>(snapshot_archive_view(bad.span()),
+            threads, args_for); }))
+        throw std::logic_error("error: corrupt archive entry should fail "
+                               "the batch");
+
+    aligned_copy bad_in_place(corrupt);
+    if(!rejected([&]{
+        return restore_all_in_place<held<int>>(
+            snapshot_archive_view(bad_in_place.span()), threads,
+            args_for); }))
+        throw std::logic_error("error: corrupt archive entry should fail "
+                               "the batch in place");
+
+    snapshots[count / 2][version] ^= 0x10;
+    streams.clear();
+    for(auto const & snapshot : snapshots)
+        streams.emplace_back(snapshot);
+    for(size_t i = 0; i < count; ++i)
+        stream_pointers[i] = &streams[i];
+    if(!rejected([&]{
+        return restore_all<held<int>>(
+            std::span<std::istream * const>{stream_pointers}, threads,
+            args_for); }))
+        throw std::logic_error("error: corrupt stream should fail the batch");
+
+    std::cout << "batch restored " << count << " coroutines" << std::endl;
+
+    return 0;
+}
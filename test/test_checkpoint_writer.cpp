@@ -0,0 +1,108 @@
+#include "saveable_coroutine.hpp"
+#include "checkpoint_writer.hpp"
+#include "held.hpp"
+
+#include <coroutine>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include <unistd.h>
+
+int main(int ac, char * av[])
+{
+    char const * path = "test_checkpoint_writer.log";
+    std::remove(path);
+
+    auto coroutine = add_one(0);
+    {
+        checkpoint_writer writer(path);
+        writer.checkpoint(1, coroutine);
+        writer.checkpoint(2, coroutine);
+        // superseded by nothing, it is torn below
+        writer.checkpoint(1, coroutine);
+        writer.flush();
+    }
+    coroutine.destroy();
+
+    // a crash in the middle of the last snapshot
+    std::ifstream whole(path, std::ios::binary | std::ios::ate);
+    std::streamoff size = whole.tellg();
+    whole.close();
+    if(::truncate(path, size - 8) != 0)
+        throw std::logic_error("error: could not truncate the log");
+
+    std::ifstream is(path, std::ios::binary);
+    checkpoint_log_reader reader(is);
+
+    if(reader.size() != 2 || !reader.contains(1) || !reader.contains(2))
+        throw std::logic_error("error: log should index ids 1 and 2");
+
+    // the torn record must not replace the good one before it
+    for(snapshot_id id : {1, 2})
+    {
+        int y = 41;
+        auto restored = reader.load<held<int>>(id, y);
+        if(restored.handle().get() != 42)
+            throw std::logic_error("error: restored coroutine should "
+                                   "return 42");
+        restored.destroy();
+    }
+
+    // a torn record header is dropped too
+    if(::truncate(path, sizeof(checkpoint_record) / 2) != 0)
+        throw std::logic_error("error: could not truncate the log");
+
+    std::ifstream header(path, std::ios::binary);
+    if(checkpoint_log_reader(header).size() != 0)
+        throw std::logic_error("error: torn header should be dropped");
+
+    // threads copy their checkpoints in parallel, through a staging buffer
+    // small enough to fill up and be swapped many times
+    std::remove(path);
+    constexpr int threads = 4;
+    int x = 41;
+    std::vector<saveable<held<int>>> chains;
+    for(int t = 0; t < threads; ++t)
+        chains.push_back(make_chain(8, x));
+
+    size_t record = sizeof(checkpoint_record) + chains[0].snapshot_size();
+    {
+        checkpoint_writer writer(path, 3 * record);
+        std::vector<std::jthread> workers;
+        for(int t = 0; t < threads; ++t)
+            workers.emplace_back([&writer, &chains, t]{
+                for(int i = 0; i < 200; ++i)
+                    writer.checkpoint(t, chains[t]);
+            });
+        workers.clear();
+        writer.flush();
+    }
+
+    std::ifstream log(path, std::ios::binary);
+    checkpoint_log_reader parallel(log);
+    if(parallel.size() != threads)
+        throw std::logic_error("error: log should index every thread");
+
+    for(int t = 0; t < threads; ++t)
+    {
+        int y = 41;
+        auto restored = parallel.load<held<int>>(t, y);
+        if(restored.snapshot() != chains[t].snapshot())
+            throw std::logic_error("error: parallel checkpoint restored "
+                                   "other frames");
+        if(restored.handle().get() != 42)
+            throw std::logic_error("error: restored coroutine should "
+                                   "return 42");
+        destroy_chain(restored.address());
+        destroy_chain(chains[t].address());
+    }
+
+    std::remove(path);
+
+    std::cout << "checkpoint log ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "tictac4.hpp"
+#include "alpha_beta.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <iostream>
+
+using search_type = alpha_beta_search<TicTac>;
+using big_search_type = alpha_beta_search<TicTac4>;
+
+int main(int ac, char * av[])
+{
+    using namespace std::chrono_literals;
+
+    // with no budget it deepens to the end of the game and agrees with a
+    // search that went there at once
+    search_type deepening, full(0);
+    size_t i = 0;
+    for(auto const & state : game_tree(TicTac{}))
+    {
+        if(i++ % 97 != 0 || state.actions().size() == 0)
+            continue;
+
+        auto r = deepening.search_within(state, {});
+        if(r.m_score != full.search(state).m_score)
+            throw std::logic_error("error: score differs from a full search");
+        // unless a win or loss was certain sooner
+        if(r.m_depth != search_type::unlimited && 
+           std::abs(r.m_score) < search_type::win_score - 9)
+            throw std::logic_error("error: should have seen every game end");
+    }
+
+    // a win one move away is found one ply deep and the search stops there
+    TicTac win;
+    for(auto m : {TicTac::TopLeft, TicTac::BottomLeft, TicTac::TopCenter,
+                  TicTac::BottomCenter})
+        win(m);
+    auto r = deepening.search_within(win, {});
+    if(r.m_action != TicTac::TopRight || r.m_depth != 1)
+        throw std::logic_error("error: should win without looking further");
+
+    // a depth budget stops it short of the end, guessing with evaluate
+    big_search_type big;
+    auto shallow = big.search_within(TicTac4{}, {.m_depth = 3});
+    if(shallow.m_depth != 3)
+        throw std::logic_error("error: should stop at the depth budget");
+
+    // a node budget returns a legal move, with not even one ply the first
+    auto few = big.search_within(TicTac4{}, {.m_nodes = 0});
+    if(few.m_depth != 0 || few.m_action != TicTac4::TopLeft)
+        throw std::logic_error("error: should fall back to the first move");
+
+    auto some = big.search_within(TicTac4{}, {.m_nodes = 2000});
+    if(some.m_nodes > 2000 || some.m_depth < 1)
+        throw std::logic_error("error: should stay within the node budget");
+
+    // a time budget is kept to, a full search of the board takes much
+    // longer.  generous so a loaded machine does not fail it
+    big.clear();
+    auto start = std::chrono::steady_clock::now();
+    auto timed = big.search_within(TicTac4{}, {.m_time = 20ms});
+    auto took = std::chrono::steady_clock::now() - start;
+    if(took > 200ms || timed.m_depth < 1 || 
+       timed.m_depth == big_search_type::unlimited)
+        throw std::logic_error("error: should stop at the time budget");
+
+    // budgeted players still play a whole game
+    GameInterface<TicTac4> game;
+    AlphaBetaInterface<TicTac4> x({.m_time = 5ms}), o({.m_nodes = 5000});
+    game.add_player(x);
+    game.add_player(o);
+    TicTac4 final = turn_based(&game).get();
+    if(!final.done())
+        throw std::logic_error("error: game should be played to the end");
+
+    std::cout << "searched " << timed.m_depth << " plies in " 
+              << std::chrono::duration<double, std::milli>(took).count()
+              << " ms, winner " << final.winner() << std::endl;
+
+    return 0;
+}
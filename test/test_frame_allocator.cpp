@@ -0,0 +1,111 @@
+#include "frame_allocator.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+// blocks of the size class the test watches that are live on the heap,
+// counted by replacing the global operator new and delete.  they are kept
+// out of line so the compiler pairs them with each other, not with malloc
+static constexpr size_t watched = 192;
+static std::atomic<long> g_watched_live{0};
+
+[[gnu::noinline]] void * operator new(size_t size)
+{
+    if(size == watched)
+        ++g_watched_live;
+    if(void * p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void * p) noexcept
+{ std::free(p); }
+
+[[gnu::noinline]] void operator delete(void * p, size_t size) noexcept
+{
+    if(size == watched)
+        --g_watched_live;
+    std::free(p);
+}
+
+using pool = pooled_frame_allocator<64, 512, 4>;
+
+int main(int ac, char * av[])
+{
+    // a freed frame comes back for any size of its class
+    void * a = pool::allocate(watched - 10);
+    pool::deallocate(a, watched - 10);
+    if(pool::cached() != 1)
+        throw std::logic_error("error: freed frame should be cached");
+
+    void * b = pool::allocate(watched - 60);
+    if(b != a || pool::cached() != 0)
+        throw std::logic_error("error: frame should be reused in its class");
+
+    // but not for another class
+    void * c = pool::allocate(watched + 10);
+    if(c == b)
+        throw std::logic_error("error: frame reused across size classes");
+    pool::deallocate(c, watched + 10);
+    pool::deallocate(b, watched - 60);
+
+    // a list holds at most MaxCached blocks, the rest go to the heap
+    pool::release();
+    long live = g_watched_live;
+    std::vector<void*> blocks;
+    for(int i = 0; i < 6; ++i)
+        blocks.push_back(pool::allocate(watched));
+    if(g_watched_live != live + 6)
+        throw std::logic_error("error: empty list should go to the heap");
+    for(void * block : blocks)
+        pool::deallocate(block, watched);
+    if(pool::cached() != 4 || g_watched_live != live + 4)
+        throw std::logic_error("error: list should cache at most 4 blocks");
+    pool::release();
+    if(pool::cached() != 0 || g_watched_live != live)
+        throw std::logic_error("error: release should empty the lists");
+
+    // sizes above the largest class go straight to the heap
+    void * big = pool::allocate(1000);
+    pool::deallocate(big, 1000);
+    if(pool::cached() != 0)
+        throw std::logic_error("error: large frame should not be cached");
+
+    // a frame freed on another thread joins that thread's list
+    void * moved = pool::allocate(watched);
+    size_t cached_there = 0;
+    std::thread([&]{
+        pool::deallocate(moved, watched);
+        cached_there = pool::cached();
+        void * again = pool::allocate(watched);
+        if(again != moved)
+            cached_there = 0;
+        pool::deallocate(again, watched);
+    }).join();
+    if(cached_there != 1 || pool::cached() != 0)
+        throw std::logic_error("error: frame freed on another thread should "
+                               "be cached there");
+
+    // and thread exit hands every cached block back to the heap
+    if(g_watched_live != live)
+        throw std::logic_error("error: thread exit should release its lists");
+
+    std::thread([]{
+        std::vector<void*> blocks;
+        for(int i = 0; i < 3; ++i)
+            blocks.push_back(pool::allocate(watched));
+        for(void * block : blocks)
+            pool::deallocate(block, watched);
+    }).join();
+    if(g_watched_live != live)
+        throw std::logic_error("error: thread exit should release its lists");
+
+    std::cout << "frame allocator ok" << std::endl;
+
+    return 0;
+}
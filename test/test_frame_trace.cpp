@@ -0,0 +1,90 @@
+// every saveable coroutine of this test records into the default trace
+#define SAVEABLE_COROUTINE_TRACE
+
+#include "saveable_coroutine.hpp"
+#include "frame_trace.hpp"
+#include "held.hpp"
+
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <iostream>
+
+using trace = default_frame_trace;
+
+static_assert(trace::enabled, "the trace should be compiled in");
+
+void expect(frame_trace_record const & record, frame_event event,
+    void const * address, std::string const & what)
+{
+    if(record.event != event || record.address != address)
+        throw std::logic_error("error: expected " + what + " of the frame, "
+            "got " + to_string(record.event));
+}
+
+int main(int ac, char * av[])
+{
+    trace::clear();
+
+    // a frame lives through allocate, construct, destruct and deallocate
+    int x = 41;
+    auto coroutine = add_one(x);
+    void * address = coroutine.address();
+    std::vector<char> snapshot = coroutine.snapshot();
+    coroutine.destroy();
+
+    // and a restored one through restore instead of the first two
+    auto restored = load_coro<held<int>>(std::span<char const>{snapshot}, x);
+    void * restored_address = restored.address();
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: restored coroutine should return 42");
+    restored.destroy();
+
+    auto records = trace::snapshot();
+    if(records.size() != 7)
+        throw std::logic_error("error: expected 7 events, got " +
+            std::to_string(records.size()));
+
+    expect(records[0], frame_event::allocate, address, "allocate");
+    expect(records[1], frame_event::construct, address, "construct");
+    expect(records[2], frame_event::destruct, address, "destruct");
+    expect(records[3], frame_event::deallocate, address, "deallocate");
+    expect(records[4], frame_event::restore, restored_address, "restore");
+    expect(records[5], frame_event::destruct, restored_address, "destruct");
+    expect(records[6], frame_event::deallocate, restored_address,
+        "deallocate");
+
+    if(records[0].size == 0 || records[4].size != records[0].size)
+        throw std::logic_error("error: restore should record the size the "
+                               "frame was allocated with");
+
+    for(size_t i = 1; i < records.size(); ++i)
+        if(records[i].timestamp < records[i - 1].timestamp)
+            throw std::logic_error("error: events should be in order");
+
+    // the ring keeps the newest Capacity events
+    constexpr size_t capacity = 4096;
+    static_assert(std::is_same_v<trace, ring_frame_trace<capacity>>);
+    trace::clear();
+    for(size_t i = 0; i < capacity + 100; ++i)
+        trace::record(frame_event::allocate, nullptr, i);
+
+    records = trace::snapshot();
+    if(records.size() != capacity)
+        throw std::logic_error("error: a full ring should hold " +
+            std::to_string(capacity) + " events");
+    for(size_t i = 0; i < capacity; ++i)
+        if(records[i].size != 100 + i)
+            throw std::logic_error("error: a wrapped ring should keep the "
+                                   "newest events, oldest first");
+
+    trace::clear();
+    if(!trace::snapshot().empty())
+        throw std::logic_error("error: clear should forget every event");
+
+    std::cout << "frame trace ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "game_server.hpp"
+#include "tictac.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// what the client side sees: players waiting for an action, nullptr once a
+// game is over
+struct client_queue
+{
+    using entry = std::pair<remote_player<TicTac>*, TicTac::Move>;
+
+    void push(entry e)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_entries.push_back(e);
+        }
+        m_cond.notify_one();
+    }
+
+    entry pop()
+    {
+        std::unique_lock lock(m_mutex);
+        m_cond.wait(lock, [this]{ return !m_entries.empty(); });
+        entry e = m_entries.front();
+        m_entries.pop_front();
+        return e;
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::deque<entry> m_entries;
+};
+
+// asks the client to play the first open square
+struct first_square : public remote_player<TicTac>
+{
+    first_square(scheduler sched, client_queue & queue) :
+        remote_player<TicTac>{sched}, m_queue{queue}
+    { }
+
+    task<void> display(TicTac const &) override
+    { co_return; }
+
+    void turn(Ranges<action_type> const & actions) override
+    { m_queue.push({this, actions.begin()->begin()}); }
+
+    client_queue & m_queue;
+};
+
+struct hosted_game
+{
+    hosted_game(scheduler sched, client_queue & queue) :
+        x{sched, queue}, o{sched, queue}
+    {
+        game.add_player(x);
+        game.add_player(o);
+    }
+
+    GameInterface<TicTac> game;
+    first_square x, o;
+    TicTac final;
+};
+
+int main(int ac, char * av[])
+{
+    constexpr size_t games = 500;
+
+    game_server server(4);
+    client_queue queue;
+
+    std::vector<std::unique_ptr<hosted_game>> hosted;
+    for(size_t i = 0; i < games; ++i)
+        hosted.push_back(std::make_unique<hosted_game>(
+            server.get_scheduler(), queue));
+
+    for(auto & h : hosted)
+        server.host(h->game, [&queue, g = h.get()](TicTac const & final) {
+            g->final = final;
+            queue.push({nullptr, TicTac::TotalMoves});
+        });
+
+    // the client answers every game from this one thread
+    size_t over = 0, moves = 0;
+    while(over < games)
+    {
+        auto [player, move] = queue.pop();
+        if(player == nullptr)
+            ++over;
+        else
+        {
+            player->submit(move);
+            ++moves;
+        }
+    }
+
+    server.wait();
+
+    if(server.finished() != games || server.active() != 0)
+        throw std::logic_error("error: every game should have finished");
+
+    for(auto & h : hosted)
+        if(h->final.winner() != TicTac::X)
+            throw std::logic_error("error: X should win every game");
+
+    // first square play ends after 7 moves
+    if(moves != 7 * games)
+        throw std::logic_error("error: unexpected number of moves");
+
+    // games parked on a client that never answers are cancelled by stop,
+    // and the destructor does not wait for them forever
+    {
+        constexpr size_t parked = 50;
+        client_queue silent;
+        std::vector<std::unique_ptr<hosted_game>> waiting;
+        size_t done = 0, cancelled = 0;
+        {
+            game_server stopping(4);
+            for(size_t i = 0; i < parked; ++i)
+            {
+                waiting.push_back(std::make_unique<hosted_game>(
+                    stopping.get_scheduler(), silent));
+                stopping.host(waiting.back()->game,
+                    [&done](TicTac const &) { ++done; });
+            }
+
+            // every game asks its first player, nobody submits
+            for(size_t i = 0; i < parked; ++i)
+                silent.pop();
+
+            stopping.stop();
+            stopping.wait();
+            cancelled = stopping.cancelled();
+
+            bool refused = false;
+            try { stopping.host(waiting.front()->game); }
+            catch(game_error const &) { refused = true; }
+
+            if(!refused)
+                throw std::logic_error("error: stopped server should refuse "
+                                       "new games");
+        }
+
+        if(cancelled != parked || done != 0)
+            throw std::logic_error("error: stop should cancel every parked "
+                                   "game without finishing it");
+
+        // a late answer to a cancelled game is dropped
+        waiting.front()->x.submit(TicTac::Move{});
+
+        // the destructor stops on its own, the game outlives the server
+        std::unique_ptr<hosted_game> left;
+        game_server abandoned(2);
+        left = std::make_unique<hosted_game>(abandoned.get_scheduler(),
+            silent);
+        abandoned.host(left->game);
+        silent.pop();
+    }
+
+    std::cout << games << " games, " << moves << " moves" << std::endl;
+
+    return 0;
+}
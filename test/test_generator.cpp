@@ -0,0 +1,188 @@
+#include "generator.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+
+#include <array>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <iostream>
+
+generator<int> count_to(int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// yields the same object every time
+generator<std::array<int, 4> const&> updates(std::array<int, 4> const *& at)
+{
+    std::array<int, 4> state{};
+    at = &state;
+    for(int i = 0; i < 3; ++i)
+    {
+        state[i] = i + 1;
+        co_yield state;
+    }
+}
+
+generator<int&> elements(int * values, int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield values[i];
+}
+
+// the string converted for the reference lives until the next element
+generator<std::string const&> converted()
+{
+    co_yield "first";
+    co_yield "second";
+}
+
+generator<int> failing()
+{
+    co_yield 1;
+    throw std::logic_error("producer failed");
+}
+
+// numbers the nodes of a binary tree in preorder
+generator<int> preorder(int depth, int & next)
+{
+    co_yield next++;
+    if(depth == 0)
+        co_return;
+
+    co_yield elements_of(preorder(depth - 1, next));
+    co_yield elements_of(preorder(depth - 1, next));
+}
+
+generator<int> nested_failure(int depth)
+{
+    if(depth == 0)
+        throw std::logic_error("deepest failed");
+
+    co_yield depth;
+    co_yield elements_of(nested_failure(depth - 1));
+}
+
+generator<std::string const&> flattened(std::vector<std::string> const & v)
+{
+    co_yield elements_of(v);
+    co_yield "last";
+}
+
+static_assert(std::input_iterator<generator<int>::iterator>);
+static_assert(std::input_iterator<generator<int const&>::iterator>);
+static_assert(std::ranges::input_range<generator<int>>);
+static_assert(std::ranges::view<generator<int>>);
+static_assert(std::ranges::view<generator<std::string const&>>);
+
+int main(int ac, char * av[])
+{
+    int sum = 0;
+    for(int i : count_to(5))
+        sum += i;
+    if(sum != 10)
+        throw std::logic_error("error: wrong sum of values");
+
+    std::array<int, 4> const * at = nullptr;
+    int seen = 0;
+    for(auto const & state : updates(at))
+    {
+        if(&state != at)
+            throw std::logic_error("error: reference should point into the "
+                                   "producer");
+        if(state[seen] != seen + 1)
+            throw std::logic_error("error: wrong state");
+        ++seen;
+    }
+    if(seen != 3)
+        throw std::logic_error("error: wrong states seen");
+
+    int values[] = {1, 2, 3};
+    for(int & v : elements(values, 3))
+        v *= 10;
+    if(values[0] != 10 || values[2] != 30)
+        throw std::logic_error("error: writes should reach the producer");
+
+    std::string joined;
+    for(auto const & s : converted())
+        joined += s;
+    if(joined != "firstsecond")
+        throw std::logic_error("error: wrong converted strings");
+
+    // dereferencing does not advance
+    auto g = count_to(3);
+    auto it = g.begin();
+    if(*it != 0 || *it != 0 || *++it != 1)
+        throw std::logic_error("error: dereference should not resume");
+
+    // a lazy pipeline, the producer stops as soon as take is satisfied
+    std::vector<int> odd;
+    for(int i : count_to(1'000'000)
+              | std::views::filter([](int i) { return i % 2 == 1; })
+              | std::views::take(3))
+        odd.push_back(i);
+    if(odd != std::vector<int>{1, 3, 5})
+        throw std::logic_error("error: wrong pipeline result");
+
+    // the whole tic-tac-toe game tree, 549946 nodes
+    if(std::ranges::distance(game_tree(TicTac{})) != 549946)
+        throw std::logic_error("error: wrong game tree size");
+
+    // the first few wins for X, found without enumerating the rest
+    int wins = 0;
+    for(auto const & state : game_tree(TicTac{})
+              | std::views::filter([](TicTac const & s) { 
+                    return s.winner() == TicTac::X; })
+              | std::views::take(3))
+        wins += state.winner() == TicTac::X;
+    if(wins != 3)
+        throw std::logic_error("error: wrong wins");
+
+    // nested generators yield in order, straight to this loop
+    int next = 0, expected = 0;
+    for(int i : preorder(4, next))
+        if(i != expected++)
+            throw std::logic_error("error: nested elements out of order");
+    if(expected != 31)
+        throw std::logic_error("error: wrong number of nested elements");
+
+    std::vector<std::string> words{"a", "b"};
+    std::string all;
+    for(auto const & w : flattened(words))
+        all += w;
+    if(all != "ablast")
+        throw std::logic_error("error: wrong flattened range");
+
+    // an exception deep down travels through every level
+    std::vector<int> depths;
+    try {
+        for(int d : nested_failure(3))
+            depths.push_back(d);
+        throw std::logic_error("error: nested exception should propagate");
+    } catch(std::logic_error const & e) {
+        if(std::string(e.what()) != "deepest failed" || depths.size() != 3)
+            throw;
+    }
+
+    // the producer's exception escapes operator++
+    int before = 0;
+    try {
+        for(int i : failing())
+            before += i;
+        throw std::logic_error("error: exception should propagate");
+    } catch(std::logic_error const & e) {
+        if(std::string(e.what()) != "producer failed" || before != 1)
+            throw;
+    }
+
+    std::cout << "generator ok" << std::endl;
+
+    return 0;
+}
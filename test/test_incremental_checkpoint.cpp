@@ -0,0 +1,145 @@
+#include "saveable_coroutine.hpp"
+#include "incremental_checkpoint.hpp"
+#include "held.hpp"
+
+#include <algorithm>
+#include <coroutine>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <iostream>
+
+// changes a local every time it is resumed
+saveable<held<int>> ticker(int x)
+{
+    std::suspend_always tick;
+    for(;;)
+    {
+        ++x;
+        co_await tick;
+    }
+}
+
+// replays every delta in deltas on top of base, checks the restored chain
+// is byte for byte the one expected
+void check_restore(std::string const & base, std::string const & deltas,
+    std::vector<char> const & expected)
+{
+    int y = 41;
+    std::istringstream bis(base), dis(deltas);
+    auto restored = load_coro_incremental<held<int>>(bis, dis, y);
+
+    if(restored.snapshot() != expected)
+        throw std::logic_error("error: restored chain differs from the "
+                               "checkpointed one");
+
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: restored coroutine should return 42");
+    destroy_chain(restored.address());
+}
+
+int main(int ac, char * av[])
+{
+    // a root frame awaiting a leaf which changes between checkpoints
+    int x = 41;
+    auto root = add_one(x);
+    auto leaf = ticker(x);
+    root.get_header()->child_address = leaf.address();
+
+    incremental_checkpoint<> tracker;
+    std::ostringstream base, deltas;
+    tracker.save_base(root, base);
+
+    // only the leaf changed
+    leaf.handle().m_handle.resume();
+    size_t changed = tracker.save_delta(root, deltas);
+    if(changed >= root.snapshot_size())
+        throw std::logic_error("error: delta should be smaller than a full "
+                               "snapshot");
+    check_restore(base.str(), deltas.str(), root.snapshot());
+
+    // nothing changed, every frame is carried over from the base
+    size_t unchanged = tracker.save_delta(root, deltas);
+    if(unchanged >= changed)
+        throw std::logic_error("error: unchanged chain should give the "
+                               "smallest delta");
+    check_restore(base.str(), deltas.str(), root.snapshot());
+
+    // a frame that is not in the base comes whole with the delta
+    auto added = add_one(x);
+    leaf.get_header()->child_address = added.address();
+    leaf.handle().m_handle.resume();
+    tracker.save_delta(root, deltas);
+    check_restore(base.str(), deltas.str(), root.snapshot());
+
+    // a delta applied to a base it was not taken against is rejected
+    std::ostringstream other;
+    auto unrelated = add_one(x);
+    unrelated.save(other);
+    unrelated.destroy();
+    bool rejected = false;
+    try { check_restore(other.str(), deltas.str(), root.snapshot()); }
+    catch(std::logic_error const &) { rejected = true; }
+
+    if(!rejected)
+        throw std::logic_error("error: delta against another base should be "
+                               "rejected");
+
+    // so is a base with bytes trailing its last frame, fewer than a header
+    std::string const all_deltas = deltas.str();
+    for(size_t trailing : {8, 64})
+    {
+        std::string const text = base.str();
+        std::vector<char> snapshot(text.begin(), text.end());
+        snapshot.resize(snapshot.size() + trailing, 'x');
+
+        std::istringstream dis(all_deltas);
+        rejected = false;
+        try { apply_checkpoint_delta(snapshot, dis); }
+        catch(std::logic_error const &) { rejected = true; }
+
+        if(!rejected)
+            throw std::logic_error("error: base with trailing bytes should be "
+                                   "rejected");
+    }
+
+    // a record whose declared size is not what its frames use is rejected,
+    // even with a checksum matching what is read
+    incremental_checkpoint<> single;
+    std::ostringstream single_base, single_delta;
+    single.save_base(root, single_base);
+    leaf.handle().m_handle.resume();
+    single.save_delta(root, single_delta);
+
+    std::string const record = single_delta.str();
+    for(long change : {-16, 8})
+    {
+        std::string bad = record;
+        bad.resize(record.size() + std::max(change, 0L), 'x');
+
+        delta_header header;
+        std::memcpy(&header, bad.data(), sizeof(header));
+        header.size += change;
+        header.checksum = 0;
+        std::memcpy(bad.data(), &header, sizeof(header));
+        header.checksum = crc32c::compute(bad.data(), record.size());
+        std::memcpy(bad.data(), &header, sizeof(header));
+
+        std::string const text = single_base.str();
+        std::vector<char> snapshot(text.begin(), text.end());
+        std::istringstream dis(bad);
+        rejected = false;
+        try { apply_checkpoint_delta(snapshot, dis); }
+        catch(std::logic_error const &) { rejected = true; }
+
+        if(!rejected)
+            throw std::logic_error("error: delta with a wrong declared size "
+                                   "should be rejected");
+    }
+
+    destroy_chain(root.address());
+
+    std::cout << "incremental checkpoint ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "tictac4.hpp"
+#include "alpha_beta.hpp"
+#include "parallel_search.hpp"
+
+#include <stdexcept>
+#include <iostream>
+
+int main(int ac, char * av[])
+{
+    work_stealing_pool pool(4);
+    scheduler sched(pool);
+
+    // the same move and score as a single thread, whatever the number of
+    // threads and however the work was shared out
+    parallel_alpha_beta_search<TicTac> one(sched, 1), two(sched, 2),
+        four(sched, 4), untabled(sched, 4, 0);
+    alpha_beta_search<TicTac> serial(0);
+
+    size_t checked = 0, i = 0;
+    for(auto const & state : game_tree(TicTac{}))
+    {
+        if(i++ % 97 != 0 || state.actions().size() == 0)
+            continue;
+
+        auto expected = sync_wait(one.search(state));
+        if(expected.m_score != serial.search(state).m_score)
+            throw std::logic_error("error: score differs from alpha-beta");
+
+        for(auto * search : {&two, &four, &untabled})
+        {
+            auto r = sync_wait(search->search(state));
+            if(r.m_score != expected.m_score || 
+               r.m_action != expected.m_action)
+                throw std::logic_error("error: threads changed the result");
+        }
+        ++checked;
+    }
+
+    // a bigger board, searched again with what the table learned
+    TicTac4 board;
+    for(int m : {5, 10})
+        board((TicTac4::Move)m);
+
+    parallel_alpha_beta_search<TicTac4> big1(sched, 1), big4(sched, 4);
+    auto expected = sync_wait(big1.search(board));
+    if(expected.m_score != alpha_beta_search<TicTac4>{}.search(board).m_score)
+        throw std::logic_error("error: score differs from alpha-beta");
+    for(int n = 0; n < 2; ++n)
+    {
+        auto r = sync_wait(big4.search(board));
+        if(r.m_score != expected.m_score || r.m_action != expected.m_action)
+            throw std::logic_error("error: threads changed the result");
+    }
+
+    // two parallel players on the game's own threads draw
+    ThreadedGame<TicTac> game(4);
+    ParallelAlphaBetaInterface<TicTac> x(game.get_scheduler()), 
+        o(game.get_scheduler());
+    game.add_player(x);
+    game.add_player(o);
+    TicTac final = sync_wait(turn_based<TicTac>(&game));
+    if(final.winner() != TicTac::Cats)
+        throw std::logic_error("error: perfect play should draw");
+
+    std::cout << checked << " positions checked, " 
+              << big4.stats().hit_rate() * 100 << "% table hits on 4x4" 
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include "task.hpp"
+#include "generator.hpp"
+#include "frame_allocator.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <iostream>
+
+struct counters
+{
+    size_t m_allocated = 0;
+    size_t m_deallocated = 0;
+};
+
+// counts what goes through it, the counters are the allocator's state
+template<typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    explicit counting_allocator(counters & c) : m_counters{&c} { }
+
+    template<typename U>
+    counting_allocator(counting_allocator<U> const & other) :
+        m_counters{other.m_counters}
+    { }
+
+    T * allocate(size_t n)
+    {
+        ++m_counters->m_allocated;
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T * p, size_t n)
+    {
+        ++m_counters->m_deallocated;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+
+    counters * m_counters;
+};
+
+task<int> add(int x, int y)
+{ co_return x + y; }
+
+task<int> add(std::allocator_arg_t, counting_allocator<char> const &,
+    int x, int y)
+{ co_return co_await add(x, y); }
+
+generator<int> count_to(std::allocator_arg_t, counting_allocator<char>, int n)
+{
+    for(int i = 0; i < n; ++i)
+        co_yield i;
+}
+
+// fails while its coroutine's parameters are copied into the frame
+struct throws_on_move
+{
+    throws_on_move() = default;
+    throws_on_move(throws_on_move const &) = default;
+    throws_on_move(throws_on_move &&)
+    { throw std::logic_error("expected"); }
+};
+
+task<int> refuse(std::allocator_arg_t, counting_allocator<char> const &,
+    throws_on_move)
+{ co_return 0; }
+
+struct adder
+{
+    task<int> add(std::allocator_arg_t, counting_allocator<char> const &,
+        int x) const
+    { co_return m_base + x; }
+
+    int m_base;
+};
+
+int main(int ac, char * av[])
+{
+    counters c;
+    counting_allocator<char> alloc(c);
+
+    if(add(std::allocator_arg, alloc, 2, 3).get() != 5)
+        throw std::logic_error("error: wrong task result");
+
+    if(c.m_allocated != 1 || c.m_deallocated != 1)
+        throw std::logic_error("error: task frame should use the allocator");
+
+    int sum = 0;
+    for(int i : count_to(std::allocator_arg, alloc, 4))
+        sum += i;
+
+    if(sum != 6 || c.m_allocated != 2 || c.m_deallocated != 2)
+        throw std::logic_error("error: generator frame should use the "
+                               "allocator");
+
+    adder a{10};
+    if(a.add(std::allocator_arg, alloc, 5).get() != 15 || c.m_allocated != 3)
+        throw std::logic_error("error: member coroutines should use the "
+                               "allocator");
+
+    // a frame whose parameters fail to copy goes back to its allocator
+    bool thrown = false;
+    try { refuse(std::allocator_arg, alloc, throws_on_move{}); }
+    catch(std::logic_error const &) { thrown = true; }
+
+    if(!thrown || c.m_allocated != c.m_deallocated)
+        throw std::logic_error("error: frame of a failed coroutine should be "
+                               "freed");
+
+    // the placement forms of operator delete free what their operator new
+    // took, from the address alone
+    using promise = task<int>::promise_type;
+    size_t before = c.m_deallocated;
+    void * frame = promise::operator new(100, std::allocator_arg, alloc, 1);
+    promise::operator delete(frame, std::allocator_arg, alloc, 1);
+
+    frame = promise::operator new(100, a, std::allocator_arg, alloc, 1);
+    promise::operator delete(frame, a, std::allocator_arg, alloc, 1);
+
+    if(c.m_deallocated != before + 2 || c.m_allocated != c.m_deallocated)
+        throw std::logic_error("error: placement delete should free the "
+                               "frame through its allocator");
+
+    // frames without an allocator argument are recycled by this thread
+    pooled_frame_allocator<>::release();
+    add(1, 2).get();
+    if(pooled_frame_allocator<>::cached() != 1)
+        throw std::logic_error("error: default frames should be pooled");
+
+    add(3, 4).get();
+    if(pooled_frame_allocator<>::cached() != 1 ||
+       c.m_allocated != c.m_deallocated)
+        throw std::logic_error("error: pooled frame should be reused");
+
+    std::cout << "frames allocated: " << c.m_allocated << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include "scheduler.hpp"
+#include "when_all.hpp"
+
+#include <atomic>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+task<std::thread::id> where(scheduler sched)
+{
+    co_await sched.schedule();
+    co_return std::this_thread::get_id();
+}
+
+task<int> fails()
+{ 
+    throw std::logic_error("expected"); 
+    co_return 0;
+}
+
+task<void> count(std::atomic<int> & counter)
+{
+    counter.fetch_add(1, std::memory_order_relaxed);
+    co_return;
+}
+
+task<int> square(scheduler sched, int x)
+{
+    co_await sched.schedule();
+    co_return x * x;
+}
+
+// finishes last unless it runs alone
+task<int> slow(scheduler sched, std::atomic<bool> & release, int x)
+{
+    co_await sched.schedule();
+    while(!release.load())
+        std::this_thread::yield();
+    co_return x;
+}
+
+task<int> sum_of_squares(scheduler sched, int n)
+{
+    std::vector<task<int>> squares;
+    for(int i = 0; i < n; ++i)
+        squares.push_back(square(sched, i));
+
+    int sum = 0;
+    for(int s : co_await when_all(sched, std::move(squares)))
+        sum += s;
+    co_return sum;
+}
+
+// a range of tasks is only taken when it is handed over
+template<typename R>
+concept takes_tasks = requires(scheduler sched, R && tasks) {
+    when_all(sched, std::forward<R>(tasks));
+    when_any(std::forward<R>(tasks));
+};
+
+using task_vector = std::vector<task<int>>;
+static_assert(takes_tasks<task_vector>);
+static_assert(!takes_tasks<task_vector &>,
+    "an lvalue range should not be moved from");
+static_assert(!takes_tasks<std::ranges::ref_view<task_vector>>,
+    "a view of lvalues should not be moved from");
+
+// the same through a range yielding rvalues, the vector is left with
+// moved from tasks
+task<int> sum_of_moved(scheduler sched, int n)
+{
+    std::vector<task<int>> squares;
+    for(int i = 0; i < n; ++i)
+        squares.push_back(square(sched, i));
+
+    auto moved = std::ranges::subrange(
+        std::make_move_iterator(squares.begin()),
+        std::make_move_iterator(squares.end()));
+
+    int sum = 0;
+    for(int s : co_await when_all(sched, moved))
+        sum += s;
+    co_return sum;
+}
+
+task<int> mixed(scheduler sched)
+{
+    std::atomic<int> counter{0};
+    auto [a, b, c] = co_await when_all(sched, square(sched, 3), 
+        count(counter), square(sched, 4));
+
+    co_return a + c + counter;
+}
+
+int main(int ac, char * av[])
+{
+    std::atomic<int> counter{0};
+    std::atomic<bool> release{false};
+
+    {
+        work_stealing_pool pool(2);
+        scheduler sched(pool);
+
+        if(sync_wait(where(sched)) == std::this_thread::get_id())
+            throw std::logic_error("error: schedule should move to the pool");
+
+        if(sync_wait(schedule_on(sched, where(sched))) == 
+            std::this_thread::get_id())
+            throw std::logic_error("error: schedule_on should run on the "
+                                   "pool");
+
+        bool rethrown = false;
+        try { sync_wait(schedule_on(sched, fails())); }
+        catch(std::logic_error const &) { rethrown = true; }
+
+        if(!rethrown)
+            throw std::logic_error("error: sync_wait should rethrow");
+
+        for(int i = 0; i < 1000; ++i)
+            spawn(sched, count(counter));
+
+        if(sync_wait(sum_of_squares(sched, 100)) != 328350)
+            throw std::logic_error("error: when_all lost a result");
+
+        if(sync_wait(sum_of_moved(sched, 100)) != 328350)
+            throw std::logic_error("error: when_all of moved tasks lost a "
+                                   "result");
+
+        if(sync_wait(mixed(sched)) != 26)
+            throw std::logic_error("error: when_all of mixed tasks");
+
+        bool rethrown_all = false;
+        try { sync_wait(when_all(sched, square(sched, 2), fails())); }
+        catch(std::logic_error const &) { rethrown_all = true; }
+
+        if(!rethrown_all)
+            throw std::logic_error("error: when_all should rethrow");
+
+        // the fast task wins, the slow one finishes in the background
+        auto first = sync_wait(when_any(sched, 
+            slow(sched, release, 1), square(sched, 5)));
+        release = true;
+
+        if(first.m_index != 1 || first.m_value != 25)
+            throw std::logic_error("error: when_any should yield the first "
+                                   "task to finish");
+
+        // the pool finishes spawned work before it is destroyed
+    }
+
+    if(counter != 1000)
+        throw std::logic_error("error: spawned tasks were lost");
+
+    std::cout << "scheduled " << counter << " tasks" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "saveable_coroutine.hpp"
+#include "snapshot_archive.hpp"
+#include "held.hpp"
+
+#include <coroutine>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+
+int main(int ac, char * av[])
+{
+    std::vector<saveable<held<int>>> coroutines;
+    snapshot_archive_writer writer;
+
+    int x = 0;
+    for(snapshot_id id = 0; id < 16; ++id)
+    {
+        coroutines.push_back(add_one(x));
+        // add out of order, the archive sorts its index
+        writer.add(1000 - id * 7, coroutines.back());
+    }
+
+    std::stringstream ss;
+    writer.write(ss);
+
+    for(auto & coroutine : coroutines)
+        coroutine.destroy();
+
+    std::string const archive = ss.str();
+
+    // restore from a stream, arguments are hydrated per coroutine
+    std::istringstream is(archive);
+    snapshot_archive_reader reader(is);
+
+    if(reader.entries().size() != 16)
+        throw std::logic_error("error: archive should index 16 coroutines");
+
+    if(reader.contains(1001))
+        throw std::logic_error("error: archive should not contain id 1001");
+
+    int y = 41;
+    auto restored = reader.load<held<int>>(1000 - 3 * 7, y);
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: restored coroutine should return 42");
+    restored.destroy();
+
+    // restore in place from aligned memory
+    aligned_copy memory(archive);
+    snapshot_archive_view view(memory.span());
+
+    for(auto const & e : view.entries())
+    {
+        int z = (int)e.id;
+        auto coroutine = view.load_in_place<held<int>>(e.id, z);
+        if(coroutine.handle().get() != (int)e.id + 1)
+            throw std::logic_error("error: in place restore returned the "
+                                   "wrong value");
+        coroutine.destroy();
+    }
+
+    bool rejected = false;
+    try { reader.load<held<int>>(1001, y); }
+    catch(std::logic_error const &) { rejected = true; }
+
+    if(!rejected)
+        throw std::logic_error("error: unknown id should be rejected");
+
+    // an entry whose hash code is not the promise type it is loaded as is
+    // rejected by every load, before its snapshot is touched
+    std::string wrong_type = archive;
+    archive_entry entry;
+    std::memcpy(&entry, wrong_type.data() + sizeof(archive_header),
+        sizeof(entry));
+    entry.hash_code ^= 1;
+    std::memcpy(wrong_type.data() + sizeof(archive_header), &entry,
+        sizeof(entry));
+
+    std::istringstream ws(wrong_type);
+    snapshot_archive_reader wrong_reader(ws);
+    aligned_copy wrong_memory(wrong_type);
+    snapshot_archive_view wrong_view(wrong_memory.span());
+
+    auto expect_rejected = [&](auto load, std::string const & name) {
+        bool rejected = false;
+        try { load(); }
+        catch(std::logic_error const &) { rejected = true; }
+
+        if(!rejected)
+            throw std::logic_error("error: " + name + " should check the "
+                                   "hash code of the entry");
+    };
+    expect_rejected([&]{ wrong_reader.load<held<int>>(entry.id, y); },
+        "reader load");
+    expect_rejected([&]{ wrong_view.load<held<int>>(entry.id, y); },
+        "view load");
+    expect_rejected([&]{ wrong_view.load_in_place<held<int>>(entry.id, y); },
+        "view load_in_place");
+
+    if(std::memcmp(wrong_view.snapshot(entry).data(),
+        archive.data() + entry.offset, entry.size) != 0)
+        throw std::logic_error("error: rejected entry should be left as is");
+
+    // a corrupt entry count is rejected before the index is allocated
+    std::string corrupt = archive;
+    archive_header header;
+    std::memcpy(&header, corrupt.data(), sizeof(header));
+    header.entry_count = std::uint64_t(1) << 40;
+    std::memcpy(corrupt.data(), &header, sizeof(header));
+
+    rejected = false;
+    std::istringstream cs(corrupt);
+    try { snapshot_archive_reader corrupt_reader(cs); }
+    catch(std::logic_error const &) { rejected = true; }
+
+    if(!rejected)
+        throw std::logic_error("error: corrupt entry count should be "
+                               "rejected");
+
+    std::cout << "restored " << view.entries().size() << " coroutines" 
+              << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "saveable_coroutine.hpp"
+#include "checksum.hpp"
+#include "held.hpp"
+
+#include <coroutine>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// true if loading the snapshot is rejected
+bool rejected(std::string const & snapshot)
+{
+    int y = 0;
+    try {
+        auto coroutine = load_coro<held<int>>(
+            std::span<char const>{snapshot.data(), snapshot.size()}, y);
+        destroy_chain(coroutine.address());
+    } catch(std::logic_error const &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int ac, char * av[])
+{
+    if(crc32c::compute("123456789", 9) != 0xe3069283)
+        throw std::logic_error("error: crc32c check value");
+
+    // three frames linked into a chain by hand
+    int x = 41;
+    auto root = add_one(x);
+    frame_header * header = root.get_header();
+    for(int i = 0; i < 2; ++i)
+    {
+        auto child = add_one(x);
+        header->child_address = child.address();
+        header = child.get_header();
+    }
+
+    std::ostringstream os;
+    root.save(os);
+    destroy_chain(root.address());
+
+    std::string const snapshot = os.str();
+    if(validate_snapshot({snapshot.data(), snapshot.size()}) != 3)
+        throw std::logic_error("error: snapshot should hold 3 frames");
+
+    int y = 41;
+    std::istringstream is(snapshot);
+    auto restored = load_coro<held<int>>(is, y);
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: restored coroutine should return 42");
+    destroy_chain(restored.address());
+
+    // every flipped bit of a header or of frame data is caught
+    size_t flipped = 0;
+    for(size_t at = 0; at < snapshot.size(); )
+    {
+        frame_header fh;
+        std::memcpy(&fh, snapshot.data() + at, sizeof(fh));
+
+        size_t covered = sizeof(frame_header) + fh.data_size;
+        for(size_t i = at; i < at + covered; ++i, ++flipped)
+        {
+            std::string corrupt = snapshot;
+            corrupt[i] ^= 0x10;
+            if(!rejected(corrupt))
+                throw std::logic_error("error: corrupt byte " + 
+                    std::to_string(i) + " was not rejected");
+        }
+
+        at += sizeof(frame_header) + padded_frame_size(fh.data_size);
+    }
+
+    // and so is every truncation
+    for(size_t size = 0; size < snapshot.size(); ++size)
+        if(!rejected(snapshot.substr(0, size)))
+            throw std::logic_error("error: truncated snapshot of " + 
+                std::to_string(size) + " bytes was not rejected");
+
+    // a corrupt size is rejected before anything is allocated for it
+    std::string huge = snapshot;
+    reinterpret_cast<frame_header*>(huge.data())->data_size = ~size_t(0) / 2;
+    std::istringstream his(huge);
+    bool rejected_huge = false;
+    try { load_coro<held<int>>(his, y); }
+    catch(std::logic_error const &) { rejected_huge = true; }
+
+    if(!rejected_huge)
+        throw std::logic_error("error: huge frame should be rejected");
+
+    std::cout << "rejected " << flipped << " corrupt bytes" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "saveable_coroutine.hpp"
+#include "snapshot_codec.hpp"
+#include "held.hpp"
+
+#include <coroutine>
+#include <random>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// a frame mostly made of zeros, which compresses well
+saveable<held<int>> scratch_frame(int x)
+{
+    std::suspend_always pause;
+    char scratch[4096] = {};
+    scratch[7] = (char)x;
+    co_await pause;
+    co_return scratch[7];
+}
+
+// compresses and decompresses data, each into a buffer of exactly the
+// size needed so any overrun is caught by the sanitizers
+void round_trip(std::vector<char> const & data, std::string const & name)
+{
+    std::vector<char> compressed = lz_codec::compress(data.data(),
+        data.size());
+    if(compressed.size() > lz_codec::max_compressed_size(data.size()))
+        throw std::logic_error("error: " + name + " compressed beyond the "
+                               "worst case");
+
+    std::vector<char> decompressed(data.size());
+    lz_codec::decompress(compressed.data(), compressed.size(),
+        decompressed.data(), decompressed.size());
+    if(decompressed != data)
+        throw std::logic_error("error: " + name + " did not round trip");
+
+    // truncations of the stream are rejected, every one of a short stream
+    size_t step = 1 + compressed.size() / 1024;
+    for(size_t size = 0; size < compressed.size(); size += step)
+    {
+        std::vector<char> truncated(compressed.begin(),
+            compressed.begin() + size);
+        bool rejected = false;
+        try {
+            lz_codec::decompress(truncated.data(), truncated.size(),
+                decompressed.data(), decompressed.size());
+        } catch(std::logic_error const &) {
+            rejected = true;
+        }
+        if(!rejected)
+            throw std::logic_error("error: " + name + " truncated to " +
+                std::to_string(size) + " bytes should be rejected");
+    }
+}
+
+// true if loading the snapshot is rejected
+bool rejected(std::vector<char> const & snapshot)
+{
+    int y = 1;
+    try {
+        auto coroutine = load_coro<held<int>>(
+            std::span<char const>{snapshot}, y);
+        coroutine.destroy();
+    } catch(std::logic_error const &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int ac, char * av[])
+{
+    std::mt19937 random(42);
+    auto bytes = [&random](size_t size, unsigned range) {
+        std::vector<char> data(size);
+        for(auto & c : data)
+            c = (char)(random() % range);
+        return data;
+    };
+
+    round_trip({}, "empty input");
+    round_trip(std::vector<char>(3, 'a'), "input below a match");
+    round_trip(std::vector<char>(1000, 0), "zeros");
+    // matches are never further back than 16 bits reach
+    round_trip(std::vector<char>(100'000, 0), "long zeros");
+    round_trip(bytes(1000, 4), "few symbols");
+
+    std::vector<char> random_bytes = bytes(4096, 256);
+    round_trip(random_bytes, "incompressible input");
+
+    std::vector<char> mixed = bytes(70'000, 256);
+    std::copy_n(mixed.begin(), 5000, mixed.begin() + 60'000);
+    std::fill_n(mixed.begin() + 10'000, 20'000, 0);
+    round_trip(mixed, "mixed input");
+
+    // random streams either decode or are rejected, never overrun
+    for(int i = 0; i < 10'000; ++i)
+    {
+        std::vector<char> garbage = bytes(1 + random() % 64, 256);
+        std::vector<char> out(random() % 256);
+        try {
+            lz_codec::decompress(garbage.data(), garbage.size(),
+                out.data(), out.size());
+        } catch(std::logic_error const &) { }
+    }
+
+    // a frame that shrinks is saved compressed and restored the same, it
+    // is started so its locals are zeros rather than whatever was allocated
+    int x = 1;
+    auto coroutine = scratch_frame(x);
+    coroutine.handle().m_handle.resume();
+
+    std::vector<char> raw = coroutine.snapshot();
+    std::vector<char> lz = coroutine.snapshot(snapshot_encoding::lz);
+    coroutine.destroy();
+
+    frame_header fh;
+    std::memcpy(&fh, lz.data(), sizeof(fh));
+    if(!(fh.flags & frame_compressed) || lz.size() >= raw.size())
+        throw std::logic_error("error: frame should be saved compressed");
+
+    auto restored = load_coro<held<int>>(std::span<char const>{lz}, x);
+    if(restored.snapshot() != raw)
+        throw std::logic_error("error: decompressed frame differs");
+    restored.destroy();
+
+    // truncated snapshots are rejected
+    for(size_t size = 0; size < lz.size(); ++size)
+        if(!rejected({lz.begin(), lz.begin() + size}))
+            throw std::logic_error("error: snapshot truncated to " +
+                std::to_string(size) + " bytes should be rejected");
+
+    // so are truncated compressed streams with a matching checksum, which
+    // only the codec can catch
+    for(size_t size = 0; size < fh.size; ++size)
+    {
+        frame_header th = fh;
+        th.size = size;
+        th.checksum = frame_checksum(th, lz.data() + sizeof(fh), 0);
+
+        std::vector<char> torn(sizeof(th) + padded_frame_size(size));
+        std::memcpy(torn.data(), &th, sizeof(th));
+        std::memcpy(torn.data() + sizeof(th), lz.data() + sizeof(fh), size);
+        if(!rejected(torn))
+            throw std::logic_error("error: compressed stream truncated to " +
+                std::to_string(size) + " bytes should be rejected");
+    }
+
+    // and a compressed size beyond the worst case
+    frame_header big = fh;
+    big.size = lz_codec::max_compressed_size(fh.data_size) + 1;
+    std::vector<char> oversized = lz;
+    std::memcpy(oversized.data(), &big, sizeof(big));
+    if(!rejected(oversized))
+        throw std::logic_error("error: oversized compressed frame should be "
+                               "rejected");
+
+    std::cout << "lz codec ok, " << raw.size() << " byte frame saved in "
+              << lz.size() << " bytes" << std::endl;
+
+    return 0;
+}
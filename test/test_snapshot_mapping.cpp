@@ -0,0 +1,120 @@
+#include "saveable_coroutine.hpp"
+#include "snapshot_mapping.hpp"
+#include "held.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <unistd.h>
+
+std::string read_file(std::string const & path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(ifs),
+            std::istreambuf_iterator<char>()};
+}
+
+// restores the snapshot at offset from the mapping, checks its frames sit in
+// the mapping, hold what was saved and return 42
+void check_restore(mapped_snapshot & mapping, size_t offset,
+    std::vector<char> const & raw, std::string const & name)
+{
+    int y = 41;
+    auto restored = load_coro<held<int>>(mapping, offset, y);
+
+    char const * begin = mapping.data().data() + offset;
+    char const * end = begin + raw.size();
+    for(void * address = restored.address(); address != nullptr; )
+    {
+        char const * p = static_cast<char const*>(address);
+        if(p < begin || p >= end)
+            throw std::logic_error("error: " + name + " frame should be "
+                                   "resumed inside the mapping");
+        address = saveable_promise<void>::header_from(address)->child_address;
+    }
+
+    if(restored.snapshot() != raw)
+        throw std::logic_error("error: " + name + " restored other frames");
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: " + name + " restored coroutine should "
+                               "return 42");
+    destroy_chain(restored.address());
+}
+
+int main(int ac, char * av[])
+{
+    int x = 41;
+    auto one = make_chain(1, x);
+    auto three = make_chain(3, x);
+    std::vector<char> raw_one = one.snapshot();
+    std::vector<char> raw_three = three.snapshot();
+
+    // two snapshots back to back in one file
+    char name[] = "/tmp/test_snapshot_mappingXXXXXX";
+    int fd = ::mkstemp(name);
+    if(fd < 0)
+        throw std::logic_error("error: could not create a file");
+    ::close(fd);
+    std::string path = name;
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        one.save(ofs);
+        three.save(ofs);
+    }
+    destroy_chain(one.address());
+    destroy_chain(three.address());
+    std::string const file = read_file(path);
+
+    {
+        mapped_snapshot mapping(path);
+        if(mapping.size() != raw_one.size() + raw_three.size())
+            throw std::logic_error("error: mapping should span the file");
+
+        check_restore(mapping, 0, raw_one, "first snapshot");
+        check_restore(mapping, raw_one.size(), raw_three, "second snapshot");
+
+        // restoring rewrote the headers, so the same bytes are not a
+        // snapshot any more
+        for(size_t offset : {size_t(0), raw_one.size()})
+        {
+            bool rejected = false;
+            int y = 41;
+            try { load_coro<held<int>>(mapping, offset, y); }
+            catch(std::logic_error const &) { rejected = true; }
+
+            if(!rejected)
+                throw std::logic_error("error: restoring in place a second "
+                                       "time should be rejected");
+        }
+
+        bool rejected = false;
+        int y = 41;
+        try { load_coro<held<int>>(mapping, mapping.size() + 1, y); }
+        catch(std::logic_error const &) { rejected = true; }
+
+        if(!rejected)
+            throw std::logic_error("error: offset past the mapping should be "
+                                   "rejected");
+    }
+
+    // the mapping is private, so the file is untouched and can be mapped
+    // and restored again
+    if(read_file(path) != file)
+        throw std::logic_error("error: restoring should not modify the file");
+
+    {
+        mapped_snapshot mapping(path, true);
+        check_restore(mapping, raw_one.size(), raw_three, "mapped again");
+    }
+
+    std::remove(path.c_str());
+
+    std::cout << "snapshot mapping ok" << std::endl;
+
+    return 0;
+}
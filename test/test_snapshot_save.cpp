@@ -0,0 +1,98 @@
+#include "saveable_coroutine.hpp"
+#include "held.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+// restores a snapshot of a chain, checks its frames and its result
+void check_restore(std::string const & saved, std::vector<char> const & raw,
+    std::string const & name)
+{
+    if(saved.size() != raw.size() ||
+       !std::equal(raw.begin(), raw.end(), saved.begin()))
+        throw std::logic_error("error: " + name + " differs from snapshot()");
+
+    int y = 41;
+    auto restored = load_coro<held<int>>(
+        std::span<char const>{saved.data(), saved.size()}, y);
+    if(restored.snapshot() != raw)
+        throw std::logic_error("error: " + name + " restored other frames");
+    if(restored.handle().get() != 42)
+        throw std::logic_error("error: " + name + " restored coroutine "
+                               "should return 42");
+    destroy_chain(restored.address());
+}
+
+int main(int ac, char * av[])
+{
+    // more frames than one writev takes vectors
+    int x = 41;
+    size_t frames = IOV_MAX;
+    auto chain = make_chain(frames, x);
+    std::vector<char> raw = chain.snapshot();
+
+    // a signal interrupting writev on a full pipe makes it return short,
+    // or fail with EINTR if nothing was written yet
+    struct sigaction action = {};
+    action.sa_handler = [](int) { };
+    ::sigaction(SIGUSR1, &action, nullptr);
+
+    int fds[2];
+    if(::pipe(fds) != 0)
+        throw std::logic_error("error: could not create a pipe");
+#ifdef F_SETPIPE_SZ
+    ::fcntl(fds[1], F_SETPIPE_SZ, 4096);
+#endif
+
+    std::string piped;
+    pthread_t writer = ::pthread_self();
+    std::thread reader([&]{
+        char buffer[1000];
+        for(ssize_t n; (n = ::read(fds[0], buffer, sizeof(buffer))) > 0; )
+        {
+            piped.append(buffer, n);
+            ::pthread_kill(writer, SIGUSR1);
+        }
+    });
+    chain.save(fds[1]);
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+    check_restore(piped, raw, "save(int) to a pipe");
+
+    // a file takes it in one go
+    std::FILE * file = std::tmpfile();
+    if(file == nullptr)
+        throw std::logic_error("error: could not create a file");
+    chain.save(::fileno(file));
+    std::string written(raw.size() + 1, '\0');
+    std::rewind(file);
+    written.resize(std::fread(written.data(), 1, written.size(), file));
+    std::fclose(file);
+    check_restore(written, raw, "save(int) to a file");
+
+    std::ostringstream buffered;
+    chain.save_buffered(buffered);
+    check_restore(buffered.str(), raw, "save_buffered");
+
+    std::ostringstream streamed;
+    chain.save(streamed);
+    check_restore(streamed.str(), raw, "save(std::ostream &)");
+
+    destroy_chain(chain.address());
+
+    std::cout << "saved " << frames << " frames" << std::endl;
+
+    return 0;
+}
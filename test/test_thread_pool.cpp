@@ -0,0 +1,49 @@
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <iostream>
+
+// every task spawns two children until depth runs out, so most work is
+// posted from inside the pool and has to be stolen to spread out
+void spawn(work_stealing_pool & pool, std::atomic<size_t> & count, 
+    int depth)
+{
+    count.fetch_add(1, std::memory_order_relaxed);
+    if(depth == 0)
+        return;
+
+    for(int i = 0; i < 2; ++i)
+        pool.submit([&pool, &count, depth]() { 
+            spawn(pool, count, depth - 1); 
+        });
+}
+
+int main(int ac, char * av[])
+{
+    std::atomic<size_t> external{0};
+    std::atomic<size_t> nested{0};
+
+    {
+        work_stealing_pool pool(4);
+
+        for(size_t i = 0; i < 100'000; ++i)
+            pool.submit([&external]() { 
+                external.fetch_add(1, std::memory_order_relaxed); 
+            });
+
+        pool.submit([&pool, &nested]() { spawn(pool, nested, 14); });
+
+        // the pool runs everything posted before it is destroyed
+    }
+
+    if(external != 100'000)
+        throw std::logic_error("error: external work was lost");
+
+    if(nested != (size_t(1) << 15) - 1)
+        throw std::logic_error("error: nested work was lost");
+
+    std::cout << "ran " << external + nested << " work items" << std::endl;
+
+    return 0;
+}
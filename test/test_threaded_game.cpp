@@ -0,0 +1,54 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <iostream>
+
+// always plays the first open square and counts the states it was shown
+struct first_square : public PlayerInterface<TicTac>
+{
+    task<void> display(TicTac const &) override
+    {
+        m_displays.fetch_add(1, std::memory_order_relaxed);
+        co_return;
+    }
+
+    task<action_type> select(Ranges<action_type> const & actions) override
+    { co_return actions.begin()->begin(); }
+
+    std::atomic<int> m_displays{0};
+};
+
+int main(int ac, char * av[])
+{
+    ThreadedGame<TicTac> game(4);
+
+    first_square x, o;
+    game.add_player(x);
+    game.add_player(o);
+
+    // display resumes the game on a pool thread
+    TicTac final = sync_wait(turn_based<TicTac>(&game));
+
+    // both fill the board from square 0 up, X completes a diagonal first
+    if(final.winner() != TicTac::X)
+        throw std::logic_error("error: X should win");
+
+    // the initial state and the state after every move
+    int moves = 0;
+    for(auto mark : final.m_board)
+        moves += mark != TicTac::Blank;
+
+    if(x.m_displays != moves + 1 || o.m_displays != moves + 1)
+        throw std::logic_error("error: every state should be displayed to "
+                               "every player");
+
+    std::cout << "winner: " << final.winner() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "alpha_beta.hpp"
+#include "transposition_table.hpp"
+
+#include <stdexcept>
+#include <iostream>
+
+using table_type = transposition_table<TicTac::Move>;
+
+int main(int ac, char * av[])
+{
+    // stores and probes, scores keep their sign
+    table_type table(1 << 12);
+    if(table.memory() > (1 << 12) || table.capacity() != (1 << 12) / 16)
+        throw std::logic_error("error: table should fill its memory");
+
+    if(table.probe(42))
+        throw std::logic_error("error: empty table should miss");
+
+    table.store(42, -123, 7, bound::lower, TicTac::Center);
+    auto e = table.probe(42);
+    if(!e || e->m_score != -123 || e->m_depth != 7 ||
+       e->m_bound != bound::lower || e->m_move != TicTac::Center)
+        throw std::logic_error("error: probe should return what was stored");
+
+    // the same key again replaces it, without a move keeps the old one
+    table.store(42, 5, 3, bound::exact, std::nullopt);
+    e = table.probe(42);
+    if(!e || e->m_score != 5 || e->m_move != TicTac::Center)
+        throw std::logic_error("error: store should update the entry");
+
+    // nothing is stored without a bound
+    table.store(43, 1, 1, bound::none, std::nullopt);
+    if(table.probe(43))
+        throw std::logic_error("error: bound::none should not be stored");
+
+    // a full bucket throws out its shallowest entry, keys one bucket
+    // count apart share a bucket
+    table_type small(64);
+    if(small.capacity() != 4)
+        throw std::logic_error("error: one bucket holds four entries");
+
+    for(std::uint64_t k = 1; k <= 4; ++k)
+        small.store(k, 0, (int)k * 10, bound::exact, std::nullopt);
+    small.store(5, 0, 50, bound::exact, std::nullopt);
+    if(small.probe(1) || !small.probe(2) || !small.probe(5))
+        throw std::logic_error("error: shallowest entry should go");
+
+    // entries from earlier searches age out before deeper new ones
+    for(int n = 0; n < 8; ++n)
+        small.new_search();
+    small.store(6, 0, 1, bound::exact, std::nullopt);
+    small.store(7, 0, 1, bound::exact, std::nullopt);
+    if(!small.probe(6) || !small.probe(7) || small.probe(2) || 
+       small.probe(3) || !small.probe(5))
+        throw std::logic_error("error: old entries should be replaced first");
+
+    small.clear();
+    if(small.probe(6) || small.probe(5))
+        throw std::logic_error("error: clear should empty the table");
+
+    // a table too small to hold the tree still finds the right scores
+    alpha_beta_search<TicTac> with_table, tiny(64), without(0);
+    if(without.table() != nullptr)
+        throw std::logic_error("error: 0 bytes should mean no table");
+
+    size_t i = 0;
+    for(auto const & state : game_tree(TicTac{}))
+    {
+        if(i++ % 97 != 0 || state.actions().size() == 0)
+            continue;
+
+        int score = without.search(state).m_score;
+        if(with_table.search(state).m_score != score ||
+           tiny.search(state).m_score != score)
+            throw std::logic_error("error: table changed a score");
+    }
+
+    // and searches fewer nodes, more so the second time
+    alpha_beta_search<TicTac> fresh;
+    size_t plain = without.search(TicTac{}).m_nodes;
+    size_t first = fresh.search(TicTac{}).m_nodes;
+    size_t again = fresh.search(TicTac{}).m_nodes;
+    if(first >= plain || again >= first)
+        throw std::logic_error("error: table should save nodes");
+
+    std::cout << plain << " nodes without a table, " << first << " with, "
+              << again << " searched again, hit rate " 
+              << fresh.stats().hit_rate() << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "task.hpp"
+#include "ranges.hpp"
+#include "list.hpp"
+#include "ring.hpp"
+#include "game.hpp"
+#include "tictac.hpp"
+#include "zobrist.hpp"
+
+#include <stdexcept>
+#include <iostream>
+#include <map>
+#include <set>
+
+using keys = zobrist_keys<9, 2>;
+
+// the keys are there at compile time
+static_assert(keys::key(0, 0) != 0);
+static_assert(keys::key(0, 0) != keys::key(0, 1));
+static_assert(zobrist_keys<9, 2, 1>::key(0, 0) != keys::key(0, 0));
+
+// the hash computed from nothing but the board
+std::uint64_t from_board(TicTac const & state)
+{
+    std::uint64_t h = 0;
+    for(unsigned m = 0; m < TicTac::TotalMoves; ++m)
+        if(state.m_board[m] != TicTac::Blank)
+            h ^= keys::key(m, state.m_board[m] - TicTac::X);
+    return h;
+}
+
+int main(int ac, char * av[])
+{
+    std::set<std::uint64_t> distinct;
+    for(unsigned s = 0; s < 9; ++s)
+        for(unsigned p = 0; p < 2; ++p)
+            distinct.insert(keys::key(s, p));
+    if(distinct.size() != 18)
+        throw std::logic_error("error: keys should be distinct");
+
+    if(TicTac{}.hash() != 0 || game_traits<TicTac>::hash(TicTac{}) != 0)
+        throw std::logic_error("error: empty board should hash to 0");
+
+    // every state in the tree hashes as its board does, and no two boards
+    // share a hash
+    std::map<std::uint64_t, TicTac> boards;
+    size_t states = 0;
+    for(auto const & state : game_tree(TicTac{}))
+    {
+        ++states;
+        if(state.hash() != from_board(state))
+            throw std::logic_error("error: play should keep the hash up to date");
+
+        auto [it, inserted] = boards.emplace(state.hash(), state);
+        if(!inserted && !(it->second == state))
+            throw std::logic_error("error: two boards share a hash");
+    }
+    if(boards.size() != 5478)
+        throw std::logic_error("error: tic-tac-toe has 5478 boards");
+
+    // the same moves in another order reach the same hash
+    TicTac a, b;
+    for(auto m : {TicTac::Center, TicTac::TopLeft, TicTac::BottomRight})
+        a(m);
+    for(auto m : {TicTac::BottomRight, TicTac::TopLeft, TicTac::Center})
+        b(m);
+    if(a.hash() != b.hash())
+        throw std::logic_error("error: transpositions should share a hash");
+
+    // an illegal move changes nothing
+    std::uint64_t before = a.hash();
+    if(a(TicTac::Center) || a.hash() != before)
+        throw std::logic_error("error: a taken square should not change the hash");
+
+    std::cout << states << " states, " << boards.size() << " boards" 
+              << std::endl;
+
+    return 0;
+}